@@ -107,6 +107,8 @@ Settings config = {
     .fullscreen    = FALSE,
     .dpi           =                                  -1,
     .threads       =                                   0,
+    .filter_cache_size =                            8192,
+    .lazy_filter_limit =                            5000,
     .scroll_method =                                   0,
     .window_format = "{w}   {c}   {t}",
     .click_to_exit = TRUE,
@@ -35,7 +35,7 @@
  */
 /**
  * @param th The ThemeHighlight
- * @param tokens Array of regexes used for matching
+ * @param tokens Array of matchers used for matching
  * @param input The input string to find the matches on
  * @param retv The Attribute list to update with matches
  *
@@ -43,7 +43,28 @@
  *
  * @returns the updated retv list.
  */
-PangoAttrList *helper_token_match_get_pango_attr ( ThemeHighlight th, GRegex **tokens, const char *input, PangoAttrList *retv );
+PangoAttrList *helper_token_match_get_pango_attr ( ThemeHighlight th, rofi_int_matcher **tokens, const char *input, PangoAttrList *retv );
+
+/**
+ * @param tokens Array of matchers used for matching
+ * @param input The input string to find the matches on
+ *
+ * Find the ranges of the input string matched by the tokens, so they can be highlighted later.
+ *
+ * @returns a newly allocated array of #rofi_range_pair (in bytes).
+ */
+GArray *helper_token_match_get_ranges ( rofi_int_matcher **tokens, const char *input );
+
+/**
+ * @param th The ThemeHighlight
+ * @param ranges Array of #rofi_range_pair, see helper_token_match_get_ranges()
+ * @param retv The Attribute list to update with matches
+ *
+ * Creates a set of pango attributes highlighting the ranges.
+ *
+ * @returns the updated retv list.
+ */
+PangoAttrList *helper_token_match_ranges_get_pango_attr ( ThemeHighlight th, const GArray *ranges, PangoAttrList *retv );
 
 /**
  * @param pfd Pango font description to validate.
@@ -27,6 +27,7 @@
 
 #ifndef ROFI_HELPER_H
 #define ROFI_HELPER_H
+#include "rofi-types.h"
 /**
  * @defgroup HELPERS Helpers
  */
@@ -54,16 +55,16 @@ int helper_parse_setup ( char * string, char ***output, int *length, ... );
  *
  * Tokenize the string on spaces.
  *
- * @returns a newly allocated array of regex objest
+ * @returns a newly allocated array of matcher objects
  */
-GRegex **tokenize ( const char *input, int case_sensitive );
+rofi_int_matcher **tokenize ( const char *input, int case_sensitive );
 
 /**
- * @param tokens Array of regex objects
+ * @param tokens Array of matcher objects
  *
- * Frees the array of regex expressions.
+ * Frees the array of matcher objects.
  */
-void tokenize_free ( GRegex ** tokens );
+void tokenize_free ( rofi_int_matcher ** tokens );
 
 /**
  * @param key The key to search for
@@ -131,7 +132,79 @@ int find_arg ( const char * const key );
  *
  * @returns TRUE when matches, FALSE otherwise
  */
-int helper_token_match ( GRegex * const *tokens, const char *input );
+int helper_token_match ( rofi_int_matcher * const *tokens, const char *input );
+
+/**
+ * @param tokens     List of (input) tokens to match.
+ * @param fields     The fields of the entry, NULL fields are skipped.
+ * @param num_fields The number of fields.
+ *
+ * Tokenized match over multiple fields, each token has to match at least one of the fields.
+ * A query can so span multiple fields, e.g. 'title-word class-word'.
+ *
+ * @returns TRUE when matches, FALSE otherwise
+ */
+int helper_token_match_fields ( rofi_int_matcher * const *tokens, const char * const *fields, unsigned int num_fields );
+
+/**
+ * Trigram index over a list of lines.
+ */
+typedef struct _RofiTrigramIndex   RofiTrigramIndex;
+
+/**
+ * @param lines  The lines to index.
+ * @param length The number of lines.
+ * @param cancel When set (from another thread) indexing is aborted, can be NULL.
+ *
+ * Build a trigram index over lines. Only trigrams of ASCII characters are indexed.
+ * Lines should not be modified while the index is in use.
+ *
+ * @returns a new index, or NULL when cancelled.
+ */
+RofiTrigramIndex *helper_trigram_index_new ( char * const *lines, unsigned int length, volatile gint *cancel );
+
+/**
+ * @param index The index to free, can be NULL.
+ *
+ * Free the trigram index.
+ */
+void helper_trigram_index_free ( RofiTrigramIndex *index );
+
+/**
+ * @param index  The trigram index.
+ * @param tokens List of (input) tokens.
+ * @param length The number of candidates. [out]
+ *
+ * Get the lines that contain all the trigrams of the literal tokens.
+ * Only these lines can match the tokens.
+ *
+ * @returns a newly allocated sorted array of line indexes, or NULL when the tokens do not restrict the lines.
+ */
+unsigned int *helper_trigram_index_query ( const RofiTrigramIndex *index, rofi_int_matcher * const *tokens, unsigned int *length );
+
+/** Set in every signature returned by helper_token_match_signature(). */
+#define ROFI_SIGNATURE_COMPUTED    ( G_GUINT64_CONSTANT ( 1 ) << 63 )
+
+/**
+ * @param input The entry, can be NULL.
+ *
+ * Calculate the signature of input: a bitmap of the (lower-cased) characters it contains.
+ * An entry can only match the tokens when all bits of helper_tokens_signature() are set
+ * in the OR-ed signatures of the strings it is matched against.
+ *
+ * @returns the signature, with ROFI_SIGNATURE_COMPUTED set.
+ */
+guint64 helper_token_match_signature ( const char *input );
+
+/**
+ * @param tokens  List of (input) tokens.
+ *
+ * Get the signature of the characters required by the tokens, regex tokens require none.
+ *
+ * @returns the signature of the tokens.
+ */
+guint64 helper_tokens_signature ( rofi_int_matcher * const *tokens );
+
 /**
  * @param cmd The command to execute.
  *
@@ -200,6 +273,45 @@ char *rofi_expand_path ( const char *input );
  */
 unsigned int levenshtein ( const char *needle, const glong needlelen, const char *haystack, const glong haystacklen );
 
+/**
+ * @param needle The decoded string to find match weight off
+ * @param haystack The decoded string to match against
+ *
+ * Levenshtein distance calculation on pre-decoded strings.
+ *
+ * @returns the levenshtein distance between needle and haystack
+ */
+unsigned int levenshtein_corpus ( const rofi_int_corpus_entry *needle, const rofi_int_corpus_entry *haystack );
+
+/**
+ * @param needle The decoded string to find match weight off
+ * @param haystack The decoded string to match against
+ * @param max The largest distance of interest
+ *
+ * Bit-parallel (Myers) levenshtein distance calculation on pre-decoded strings,
+ * that stops as soon as the distance is known to exceed max.
+ *
+ * @returns the levenshtein distance between needle and haystack, or max + 1 if it is larger than max
+ */
+unsigned int levenshtein_corpus_bounded ( const rofi_int_corpus_entry *needle, const rofi_int_corpus_entry *haystack, unsigned int max );
+
+/**
+ * @param entry The entry to fill.
+ * @param str   The UTF-8 string to decode.
+ * @param case_sensitive Whether case is significant.
+ *
+ * Decode str, and when not case sensitive, store the lower-cased form.
+ * Free the content with helper_corpus_entry_clear().
+ */
+void helper_corpus_entry_init ( rofi_int_corpus_entry *entry, const char *str, int case_sensitive );
+
+/**
+ * @param entry The entry to clear.
+ *
+ * Free the content of entry and reset it.
+ */
+void helper_corpus_entry_clear ( rofi_int_corpus_entry *entry );
+
 /**
  * @param data the unvalidated character array holding possible UTF-8 data
  * @param length the length of the data array
@@ -210,6 +322,27 @@ unsigned int levenshtein ( const char *needle, const glong needlelen, const char
  */
 char * rofi_force_utf8 ( const gchar *data, ssize_t length );
 
+/**
+ * @param data the character array holding possible UTF-8 data, allocated with g_malloc and terminated at length.
+ * @param length the length of the data array
+ *
+ * Like rofi_force_utf8(), but takes ownership of data. When it is valid UTF-8, data is returned without copying.
+ *
+ * @returns the UTF-8 string
+ */
+char * rofi_force_utf8_take ( gchar *data, gsize length );
+
+/**
+ * @param data the character array to check
+ * @param length the length of the data array
+ *
+ * Check if data is valid UTF-8, without NUL bytes. Runs of ASCII are skipped a (SSE2) block at a time,
+ * as is common for this input.
+ *
+ * @returns TRUE when data is valid UTF-8.
+ */
+gboolean rofi_utf8_validate ( const char *data, gsize length );
+
 /**
  * @param input the char array holding latin text
  * @param length the length of the data array
@@ -231,6 +364,16 @@ char * rofi_latin_to_utf8_strdup ( const char *input, gssize length );
  * @returns the sorting weight.
  */
 int rofi_scorer_fuzzy_evaluate ( const char *pattern, glong plen, const char *str, glong slen );
+
+/**
+ * @param pattern   The decoded user input to match against.
+ * @param str       The decoded input to match against pattern.
+ *
+ * FZF like fuzzy sorting algorithm on pre-decoded strings.
+ *
+ * @returns the sorting weight.
+ */
+int rofi_scorer_fuzzy_evaluate_corpus ( const rofi_int_corpus_entry *pattern, const rofi_int_corpus_entry *str );
 /*@}*/
 
 /**
@@ -31,7 +31,7 @@
 #include <gmodule.h>
 
 /** ABI version to check if loaded plugin is compatible. */
-#define ABI_VERSION    0x00000005
+#define ABI_VERSION    0x00000007
 
 /**
  * @param data Pointer to #Mode object.
@@ -74,7 +74,39 @@ typedef char * ( *_mode_get_completion )( const Mode *sw, unsigned int selected_
  *
  * @returns 1 when it matches, 0 if not.
  */
-typedef int ( *_mode_token_match )( const Mode *data, GRegex **tokens, unsigned int index );
+typedef int ( *_mode_token_match )( const Mode *data, rofi_int_matcher **tokens, unsigned int index );
+
+/**
+ * @param sw The #Mode pointer
+ * @param index The entry to query.
+ *
+ * Get the character signature of all strings the entry is matched against.
+ * See helper_token_match_signature().
+ *
+ * @returns the signature of the entry.
+ */
+typedef guint64 ( *_mode_get_signature )( const Mode *sw, unsigned int index );
+
+/**
+ * @param sw The #Mode pointer
+ * @param tokens The tokens to match.
+ * @param length The number of candidates. [out]
+ *
+ * Get the entries that can match the tokens, for example from an index.
+ *
+ * @returns a newly allocated sorted array of entry indexes, or NULL if all entries should be checked.
+ */
+typedef unsigned int * ( *_mode_get_candidates )( const Mode *sw, rofi_int_matcher **tokens, unsigned int *length );
+
+/**
+ * @param sw The #Mode pointer
+ * @param selected_line The selected line
+ *
+ * Obtains the string to complete, without copying it.
+ *
+ * @returns the completion string owned by the mode, valid until the entries change.
+ */
+typedef const char * ( *_mode_get_completion_string )( const Mode *sw, unsigned int selected_line );
 
 /**
  * @param sw The #Mode pointer
@@ -169,6 +201,13 @@ struct rofi_mode
 
     _mode_get_message       _get_message;
 
+    /** Get the character signature of the entry, optional. */
+    _mode_get_signature     _get_signature;
+    /** Get the entries that can match, optional. */
+    _mode_get_candidates    _get_candidates;
+    /** Get the 'completed' entry without copying it, optional. */
+    _mode_get_completion_string _get_completion_string;
+
     /** Pointer to private data. */
     void                    *private_data;
 
@@ -27,6 +27,7 @@
 
 #ifndef ROFI_MODE_H
 #define ROFI_MODE_H
+#include "rofi-types.h"
 /**
  * @defgroup MODE Mode
  *
@@ -130,6 +131,17 @@ char * mode_get_display_value ( const Mode *mode, unsigned int selected_line, in
  */
 char * mode_get_completion ( const Mode *mode, unsigned int selected_line );
 
+/**
+ * @param mode The mode to query
+ * @param selected_line The entry to query
+ *
+ * Same as mode_get_completion(), but the string is owned by the mode and stays valid until the
+ * entries of the mode change.
+ *
+ * @returns the completion string, or NULL if the mode cannot provide it without allocating.
+ */
+const char * mode_get_completion_string ( const Mode *mode, unsigned int selected_line );
+
 /**
  * @param mode The mode to query
  * @param menu_retv The menu return value.
@@ -151,7 +163,29 @@ ModeMode mode_result ( Mode *mode, int menu_retv, char **input, unsigned int sel
  *
  * @returns TRUE if matches
  */
-int mode_token_match ( const Mode *mode, GRegex **tokens, unsigned int selected_line );
+int mode_token_match ( const Mode *mode, rofi_int_matcher **tokens, unsigned int selected_line );
+
+/**
+ * @param mode The mode to query
+ * @param selected_line The index of the entry
+ *
+ * Get the character signature of the entry, used to skip entries that cannot match.
+ * If the mode does not provide it, all bits are set.
+ *
+ * @returns the signature of the entry
+ */
+guint64 mode_get_match_signature ( const Mode *mode, unsigned int selected_line );
+
+/**
+ * @param mode The mode to query
+ * @param tokens The set of tokens to match against
+ * @param length The number of candidates. [out]
+ *
+ * Get the entries that can match the tokens, only these need to be passed to mode_token_match().
+ *
+ * @returns a newly allocated sorted array of entry indexes, or NULL if all entries should be checked.
+ */
+unsigned int *mode_get_candidates ( const Mode *mode, rofi_int_matcher **tokens, unsigned int *length );
 
 /**
  * @param mode The mode to query
@@ -0,0 +1,148 @@
+/*
+ * rofi
+ *
+ * MIT/X11 License
+ * Copyright © 2013-2017 Qball Cow <qball@gmpclient.org>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#ifndef ROFI_TYPES_H
+#define ROFI_TYPES_H
+
+#include <glib.h>
+
+/**
+ * @defgroup MATCHER Matcher
+ * @ingroup HELPERS
+ *
+ * Compiled representation of a single token of the user input.
+ * These are created by tokenize() and should only be inspected by the
+ * matching functions in helper.c.
+ *
+ * @{
+ */
+
+/**
+ * The engine used to match a token.
+ */
+typedef enum
+{
+    /** Match using a compiled GRegex. */
+    ROFI_MATCHER_REGEX   = 0,
+    /** Match as a literal (optionally case folded) substring. */
+    ROFI_MATCHER_LITERAL = 1,
+    /** Match the characters as a (optionally case folded) subsequence. */
+    ROFI_MATCHER_FUZZY   = 2,
+    /** Match a glob pattern using shift-and automatons. */
+    ROFI_MATCHER_GLOB    = 3,
+} RofiMatcherType;
+
+/** Maximum length (in characters) of a glob segment. */
+#define ROFI_GLOB_SEGMENT_MAX_LENGTH    64
+
+/**
+ * Part of a glob pattern between two '*'.
+ * Compiled into a shift-and automaton, bit i is set in a mask if that character
+ * can match position i in the segment.
+ */
+typedef struct
+{
+    /** Length in characters. */
+    unsigned int length;
+    /** Mask for each ASCII character. */
+    guint64      ascii_mask[128];
+    /** Mask of the positions matching any non ASCII character ('?'). */
+    guint64      any_mask;
+    /** The non ASCII character for each position (lower-cased when case insensitive), 0 otherwise. */
+    gunichar     *uchars;
+} rofi_int_glob_segment;
+
+/**
+ * Automaton finding all literal tokens of a query in a single pass, see tokenize().
+ */
+typedef struct _RofiLiteralSet   RofiLiteralSet;
+
+/**
+ * A single compiled token.
+ */
+typedef struct rofi_int_matcher_t
+{
+    /** The engine used to match this token. */
+    RofiMatcherType       type;
+    /** If matching is case sensitive. */
+    gboolean              case_sensitive;
+    /** Compiled regex (ROFI_MATCHER_REGEX only) */
+    GRegex                *regex;
+    /** The needle, ASCII lower-cased when not case sensitive. */
+    char                  *needle;
+    /** Length of needle in bytes. */
+    size_t                needle_len;
+    /** Decoded needle, lower-cased when not case sensitive. */
+    gunichar              *uneedle;
+    /** Length of uneedle in characters. */
+    glong                 uneedle_len;
+    /** If the needle is pure ASCII. */
+    gboolean              ascii;
+    /** ROFI_MATCHER_FUZZY: strpbrk() accept set (4 bytes) for each ASCII needle character. */
+    char                  *accept;
+    /** ROFI_MATCHER_GLOB: The (non-empty) segments between the '*'. */
+    rofi_int_glob_segment *segments;
+    /** ROFI_MATCHER_GLOB: The number of segments. */
+    unsigned int          num_segments;
+    /** ROFI_MATCHER_GLOB: If the pattern starts with a '*'. */
+    gboolean              leading_star;
+    /** ROFI_MATCHER_GLOB: If the pattern ends with a '*'. */
+    gboolean              trailing_star;
+    /** Characters an entry needs to contain to match, see helper_token_match_signature(). */
+    guint64               signature;
+    /** First token only: automaton finding the literal tokens, NULL if none. */
+    RofiLiteralSet        *literals;
+    /** Bit of this token in the results of literals, 0 when not part of it. */
+    guint64               literal_mask;
+} rofi_int_matcher;
+
+/**
+ * Decoded (and case folded) form of a string, built once and re-used for scoring.
+ */
+typedef struct
+{
+    /** The decoded characters. */
+    gunichar *chars;
+    /** The lower-cased characters, NULL when equal to chars. */
+    gunichar *folded;
+    /** Number of characters. */
+    glong    length;
+} rofi_int_corpus_entry;
+
+/**
+ * Range (in bytes) of a string matched by a token.
+ */
+typedef struct
+{
+    /** Start of the range. */
+    int start;
+    /** End of the range (exclusive). */
+    int end;
+} rofi_range_pair;
+
+/*@}*/
+#endif // ROFI_TYPES_H
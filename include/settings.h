@@ -134,7 +134,7 @@ typedef struct
     int            element_height;
     /** Sidebar mode, show the modi */
     unsigned int   sidebar_mode;
-    /** Lazy filter limit. */
+    /** Number of entries above which filtering is deferred while typing (0 to disable). */
     unsigned int   lazy_filter_limit;
     /** Auto select. */
     unsigned int   auto_select;
@@ -157,6 +157,8 @@ typedef struct
     int            dpi;
     /** Number threads (1 to disable) */
     unsigned int   threads;
+    /** Memory (KiB) used to cache filter results (0 to disable) */
+    unsigned int   filter_cache_size;
     unsigned int   scroll_method;
 
     char           *window_format;
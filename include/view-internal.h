@@ -46,84 +46,136 @@
 struct RofiViewState
 {
     /** #Mode bound to to this view. */
-    Mode             *sw;
+    Mode                  *sw;
 
     /** Flag indicating if view needs to be refiltered. */
-    int              refilter;
+    int                   refilter;
     /** Widget representing the main container. */
-    container        *main_window;
+    container             *main_window;
     /** Main #box widget holding different elements. */
-    box              *main_box;
+    box                   *main_box;
     /** #box widget packing the input bar widgets. */
-    box              *input_bar;
+    box                   *input_bar;
     /** #textbox showing the prompt in the input bar. */
-    textbox          *prompt;
+    textbox               *prompt;
     /** #textbox with the user input in the input bar. */
-    textbox          *text;
+    textbox               *text;
     /** #textbox showing the state of the case sensitive and sortng. */
-    textbox          *case_indicator;
+    textbox               *case_indicator;
 
     /** #listview holding the displayed elements. */
-    listview         *list_view;
+    listview              *list_view;
     /** #textbox widget showing the overlay. */
-    textbox          *overlay;
+    textbox               *overlay;
     /** #container holding the message box */
-    container        *mesg_box;
+    container             *mesg_box;
     /** #textbox containing the message entry */
-    textbox          *mesg_tb;
+    textbox               *mesg_tb;
 
-    /** Array with the levenshtein distance for each eleemnt. */
-    int              *distance;
+    /** Array with the sort key (see SORT_KEY()) of each filtered element, in line_map order. */
+    guint64               *sort_keys;
+    /** Array with the character signature of each entry, 0 until computed. */
+    guint64               *signatures;
+    /** Array with the decoded entries, filled when first scored. */
+    rofi_int_corpus_entry *corpus;
+    /** Case sensitivity the corpus was folded with. */
+    int                   corpus_case_sensitive;
+    /** User input of the previous filter, NULL if all entries should be checked. */
+    char                  *filter_text;
+    /** Preprocessed pattern of the previous filter. */
+    char                  *filter_pattern;
+    /** Matching method of the previous filter. */
+    int                   filter_matching_method;
+    /** Case sensitivity of the previous filter. */
+    int                   filter_case_sensitive;
+    /** Sorting of the previous filter. */
+    int                   filter_sort;
+    /** Levenshtein sorting of the previous filter. */
+    int                   filter_levenshtein_sort;
+    /** Number of entries when the previous filter ran, entries after it were appended since. */
+    unsigned int          filter_num_lines;
+    /** Results of recent filters, most recently used first. */
+    GQueue                filter_cache;
+    /** Memory (bytes) used by filter_cache. */
+    gsize                 filter_cache_size;
+    /** Filter running in the background, NULL if none. */
+    struct _FilterJob     *filter_job;
+    /** Incremented to cancel filter_job. */
+    volatile gint         filter_generation;
+    /** Highlighted ranges of drawn entries for the current tokens, by (unfiltered) entry. */
+    GHashTable            *highlight_cache;
+    /** Timeout running a deferred filter (see config.lazy_filter_limit), 0 if none. */
+    guint                 refilter_timeout;
+    /** Average time (us) a filter took. */
+    gint64                filter_time;
+    /** Average time (us) between input changes. */
+    gint64                refilter_interval;
+    /** Time (us) of the last input change, 0 if none. */
+    gint64                refilter_requested;
+    /** The pending refilter was requested by an input change. */
+    gboolean              refilter_input;
     /** Array with the translation between the filtered and unfiltered list. */
-    unsigned int     *line_map;
+    unsigned int          *line_map;
     /** number of (unfiltered) elements to show. */
-    unsigned int     num_lines;
+    unsigned int          num_lines;
+    /** number of elements line_map, sort_keys, signatures and corpus have room for. */
+    unsigned int          allocated_lines;
 
     /** number of (filtered) elements to show. */
-    unsigned int     filtered_lines;
+    unsigned int          filtered_lines;
+    /** number of (filtered) elements at the start of line_map that are in their final order. */
+    unsigned int          sorted_lines;
 
     /** Previously called key action. */
-    KeyBindingAction prev_action;
+    KeyBindingAction      prev_action;
     /** Time previous key action was executed. */
-    xcb_timestamp_t  last_button_press;
+    xcb_timestamp_t       last_button_press;
 
     /** Indicate view should terminate */
-    int              quit;
+    int                   quit;
     /** Indicate if we should absorb the key release */
-    int              skip_absorb;
+    int                   skip_absorb;
     /** The selected line (in the unfiltered list) */
-    unsigned int     selected_line;
+    unsigned int          selected_line;
     /** The return state of the view */
-    MenuReturn       retv;
+    MenuReturn            retv;
     /** Monitor #workarea the view is displayed on */
-    workarea         mon;
+    workarea              mon;
 
     /** #box holding the different modi buttons */
-    box              *sidebar_bar;
+    box                   *sidebar_bar;
     /** number of modi to display */
-    unsigned int     num_modi;
+    unsigned int          num_modi;
     /** Array of #textbox that act as buttons for switching modi */
-    textbox          **modi;
+    textbox               **modi;
     /** Settings of the menu */
-    MenuFlags        menu_flags;
+    MenuFlags             menu_flags;
     /** If mouse was within view previously */
-    int              mouse_seen;
+    int                   mouse_seen;
     /** Flag indicating if view needs to be reloaded. */
-    int              reload;
+    int                   reload;
+    /** Flag indicating entries were appended, only they need to be filtered. */
+    int                   reload_append;
     /** The funciton to be called when finalizing this view */
-    void             ( *finalize )( struct RofiViewState *state );
+    void                  ( *finalize )( struct RofiViewState *state );
 
     /** Width of the view */
-    int              width;
+    int                   width;
     /** Height of the view */
-    int              height;
+    int                   height;
     /** X position of the view */
-    int              x;
+    int                   x;
     /** Y position of the view */
-    int              y;
+    int                   y;
 
-    /** Regexs used for matching */
-    GRegex           **tokens;
+    /** Matchers used for matching */
+    rofi_int_matcher      **tokens;
+    /** Preprocessed input the tokens were compiled from, NULL if none. */
+    char                  *tokens_pattern;
+    /** Matching method the tokens were compiled with. */
+    int                   tokens_matching_method;
+    /** Case sensitivity the tokens were compiled with. */
+    int                   tokens_case_sensitive;
 };
 /** @} */
 #endif
@@ -91,7 +91,7 @@ MenuReturn rofi_view_get_return_value ( const RofiViewState *state );
  *
  * @return the next position.
  */
-unsigned int rofi_view_get_next_position ( const RofiViewState *state );
+unsigned int rofi_view_get_next_position ( RofiViewState *state );
 /**
  * @param state the Menu handle
  * @param event the event to handle
@@ -218,6 +218,20 @@ void rofi_view_hide ( void );
  */
 void rofi_view_reload ( void  );
 
+/**
+ * Indicate the current view that entries were appended to its mode, the existing entries did not change.
+ * Only the new entries are filtered and added to the current result.
+ *
+ * The reloading happens 'lazy', multiple calls might be handled at once.
+ */
+void rofi_view_reload_append ( void  );
+
+/**
+ * Stop filtering the current view in the background, waiting for the workers to finish.
+ * A mode should call this before it modifies entries that are being filtered.
+ */
+void rofi_view_filter_cancel ( void );
+
 /**
  * @param state The handle to the view
  * @param mode The new mode to display
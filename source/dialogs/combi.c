@@ -180,7 +180,7 @@ static ModeMode combi_mode_result ( Mode *sw, int mretv, char **input, unsigned
     }
     return MODE_EXIT;
 }
-static int combi_mode_match ( const Mode *sw, GRegex **tokens, unsigned int index )
+static int combi_mode_match ( const Mode *sw, rofi_int_matcher **tokens, unsigned int index )
 {
     CombiModePrivateData *pd = mode_get_private_data ( sw );
     for ( unsigned i = 0; i < pd->num_switchers; i++ ) {
@@ -193,6 +193,16 @@ static int combi_mode_match ( const Mode *sw, GRegex **tokens, unsigned int inde
     }
     return 0;
 }
+static guint64 combi_get_signature ( const Mode *sw, unsigned int index )
+{
+    CombiModePrivateData *pd = mode_get_private_data ( sw );
+    for ( unsigned i = 0; i < pd->num_switchers; i++ ) {
+        if ( index >= pd->starts[i] && index < ( pd->starts[i] + pd->lengths[i] ) ) {
+            return mode_get_match_signature ( pd->switchers[i].mode, index - pd->starts[i] );
+        }
+    }
+    return G_MAXUINT64;
+}
 static char * combi_mgrv ( const Mode *sw, unsigned int selected_line, int *state, GList **attr_list, int get_entry )
 {
     CombiModePrivateData *pd = mode_get_private_data ( sw );
@@ -283,6 +293,7 @@ Mode combi_mode =
     ._result            = combi_mode_result,
     ._destroy           = combi_mode_destroy,
     ._token_match       = combi_mode_match,
+    ._get_signature     = combi_get_signature,
     ._get_completion    = combi_get_completion,
     ._get_display_value = combi_mgrv,
     ._preprocess_input  = combi_preprocess_input,
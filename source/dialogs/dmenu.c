@@ -40,6 +40,7 @@
 #include <gio/gunixinputstream.h>
 #include <sys/types.h>
 #include <sys/stat.h>
+#include <sys/mman.h>
 #include <fcntl.h>
 #include "rofi.h"
 #include "settings.h"
@@ -69,6 +70,21 @@ static inline void bittoggle ( uint32_t *array, unsigned int index )
     *v ^= 1 << bit;
 }
 
+/** Number of blocks in the ring of the reader thread, the reader waits when it is full. */
+#define DMENU_READER_RING_SIZE    64
+
+/**
+ * A pending read of the async reader.
+ * GIO runs the read in a worker thread, so it can outlive the private data.
+ */
+typedef struct
+{
+    /** The dmenu private data, NULL when it was freed during the read. */
+    gpointer pd;
+    /** The buffer read into, handed over when pd was freed. */
+    char     *buffer;
+} DmenuAsyncRead;
+
 typedef struct
 {
     /** Settings */
@@ -100,66 +116,308 @@ typedef struct
     gulong            cancel_source;
     GInputStream      *input_stream;
     GDataInputStream  *data_input_stream;
+    // Buffer of the async reader, starts with the partial record carried over from the previous read.
+    char              *async_buffer;
+    gsize             async_buffer_size;
+    gsize             async_buffer_fill;
+    // The read in progress, NULL if none.
+    DmenuAsyncRead    *async_read;
+    // Reader thread (-async-read-thread), hands blocks of lines to the main thread through a ring.
+    GThread           *reader_thread;
+    // Dispatched on the main thread when the reader wakes it.
+    GSource           *reader_source;
+    // Set while a wake up of the main thread is pending.
+    volatile gint     reader_wakeup;
+    GPtrArray         *reader_ring[DMENU_READER_RING_SIZE];
+    // Number of blocks published by the reader.
+    volatile gint     reader_head;
+    // Number of blocks consumed by the main thread.
+    volatile gint     reader_tail;
+    volatile gint     reader_cancel;
+    volatile gint     reader_done;
+    // The reader waits on these while the ring is full.
+    GMutex            reader_mutex;
+    GCond             reader_cond;
+    // Memory mapped -input file, valid UTF-8 lines point into it.
+    char              *map;
+    gsize             map_length;
+    // Number of bytes of the mapping split into lines.
+    gsize             map_offset;
+    // Splits the mapping in the background (async mode).
+    guint             map_source;
+
+    // Trigram index, built in the background once all input is read.
+    unsigned int      index_min_lines;
+    GThread           *index_thread;
+    RofiTrigramIndex  *index;
+    volatile gint     index_cancel;
 } DmenuModePrivateData;
 
+/** Default for -index-min-lines, only build the trigram index for inputs with at least this many lines. */
+#define DMENU_INDEX_MIN_LINES      100000
+/** Size of the reads done by the async reader, grown when a single record does not fit. */
+#define DMENU_ASYNC_BUFFER_SIZE    ( 256 * 1024 )
+
+static gpointer dmenu_index_thread ( gpointer data )
+{
+    DmenuModePrivateData *pd    = (DmenuModePrivateData *) data;
+    RofiTrigramIndex     *index = helper_trigram_index_new ( pd->cmd_list, pd->cmd_list_length, &( pd->index_cancel ) );
+    g_atomic_pointer_set ( &( pd->index ), index );
+    g_debug ( "Trigram index %s.", index ? "ready" : "cancelled" );
+    return NULL;
+}
+
+/**
+ * @param pd The dmenu private data.
+ *
+ * Start building the trigram index, should be called when no more lines are added.
+ */
+static void dmenu_index_start ( DmenuModePrivateData *pd )
+{
+    if ( pd->index_thread != NULL || pd->index_min_lines == 0 || pd->cmd_list_length < pd->index_min_lines ) {
+        return;
+    }
+    GError *error = NULL;
+    pd->index_thread = g_thread_try_new ( "dmenu-index", dmenu_index_thread, pd, &error );
+    if ( error != NULL ) {
+        g_warning ( "Failed to start indexing thread: %s", error->message );
+        g_error_free ( error );
+    }
+}
+
 static void async_close_callback ( GObject *source_object, GAsyncResult *res, G_GNUC_UNUSED gpointer user_data )
 {
     g_input_stream_close_finish ( G_INPUT_STREAM ( source_object ), res, NULL );
     g_debug ( "Closing data stream." );
 }
 
-static void read_add ( DmenuModePrivateData * pd, char *data, gsize len )
+/**
+ * @param pd   The dmenu private data.
+ * @param line The line to add, owned by the list unless it points into the mapped input.
+ *
+ * Append a line to the list.
+ */
+static void read_add_line ( DmenuModePrivateData * pd, char *line )
 {
     if ( ( pd->cmd_list_length + 2 ) > pd->cmd_list_real_length ) {
+        // Do not move the list while it is being filtered.
+        // Appending in place is fine, the filter only reads the entries that were there when it started.
+        rofi_view_filter_cancel ();
         pd->cmd_list_real_length = MAX ( pd->cmd_list_real_length * 2, 512 );
         pd->cmd_list             = g_realloc ( pd->cmd_list, ( pd->cmd_list_real_length ) * sizeof ( char* ) );
     }
-    char *utfstr = rofi_force_utf8 ( data, len );
-    pd->cmd_list[pd->cmd_list_length]     = utfstr;
+    pd->cmd_list[pd->cmd_list_length]     = line;
     pd->cmd_list[pd->cmd_list_length + 1] = NULL;
 
     pd->cmd_list_length++;
 }
-static void async_read_callback ( GObject *source_object, GAsyncResult *res, gpointer user_data )
+static void read_add ( DmenuModePrivateData * pd, char *data, gsize len )
 {
-    GDataInputStream     *stream = (GDataInputStream *) source_object;
-    DmenuModePrivateData *pd     = (DmenuModePrivateData *) user_data;
-    gsize                len;
-    char                 *data = g_data_input_stream_read_upto_finish ( stream, res, &len, NULL );
-    if ( data != NULL ) {
-        // Absorb separator, already in buffer so should not block.
-        g_data_input_stream_read_byte ( stream, NULL, NULL );
-        read_add ( pd, data, len );
-        g_free ( data );
-        rofi_view_reload ();
-
-        g_data_input_stream_read_upto_async ( pd->data_input_stream, &( pd->separator ), 1, G_PRIORITY_LOW, pd->cancel,
-                                              async_read_callback, pd );
-        return;
+    read_add_line ( pd, rofi_force_utf8 ( data, len ) );
+}
+
+/**
+ * @param pd   The dmenu private data.
+ * @param line The line to check.
+ *
+ * @returns TRUE when line points into the mapped input, and so should not be freed.
+ */
+static inline gboolean dmenu_line_is_mapped ( const DmenuModePrivateData *pd, const char *line )
+{
+    return pd->map != NULL && line >= pd->map && line < ( pd->map + pd->map_length );
+}
+
+/**
+ * @param pd The dmenu private data.
+ * @param fd The opened -input file.
+ *
+ * Map a regular input file in memory, so lines do not have to be read and allocated one by one.
+ * The mapping is private and writable, so the separators can be replaced by the string terminator.
+ * This is not zero-copy: writing the terminators copies every page on write, so the file still ends up
+ * in memory once, but as one block instead of a heap string per line.
+ *
+ * @returns TRUE when the file is mapped, FALSE when it should be read as a stream.
+ */
+static gboolean dmenu_mmap_input ( DmenuModePrivateData *pd, int fd )
+{
+    struct stat sb;
+    if ( fstat ( fd, &sb ) != 0 || !S_ISREG ( sb.st_mode ) || sb.st_size <= 0 ) {
+        return FALSE;
     }
-    else {
-        GError *error = NULL;
-        // Absorb separator, already in buffer so should not block.
-        // If error == NULL end of stream..
-        g_data_input_stream_read_byte ( stream, NULL, &error );
-        if (  error == NULL ) {
-            // Add empty line.
-            read_add ( pd, "", 0 );
-            rofi_view_reload ();
-
-            g_data_input_stream_read_upto_async ( pd->data_input_stream, &( pd->separator ), 1, G_PRIORITY_LOW, pd->cancel,
-                                                  async_read_callback, pd );
-            return;
+    void *map = mmap ( NULL, sb.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0 );
+    if ( map == MAP_FAILED ) {
+        g_debug ( "Failed to map input file: %s", g_strerror ( errno ) );
+        return FALSE;
+    }
+    pd->map        = map;
+    pd->map_length = sb.st_size;
+    return TRUE;
+}
+
+/**
+ * @param pd  The dmenu private data.
+ * @param max Split the lines that start in the next max bytes.
+ *
+ * Split the mapped input into lines. Lines that are valid UTF-8 are used in place,
+ * only invalid lines (and the last line if it is not terminated) are copied.
+ *
+ * @returns TRUE when the whole mapping is split.
+ */
+static gboolean dmenu_mmap_split ( DmenuModePrivateData *pd, gsize max )
+{
+    char       *iter = pd->map + pd->map_offset;
+    const char *end  = pd->map + pd->map_length;
+    const char *stop = ( max < (gsize) ( end - iter ) ) ? ( iter + max ) : end;
+    while ( iter < stop ) {
+        char *sep = memchr ( iter, pd->separator, end - iter );
+        if ( sep == NULL ) {
+            // There is no room for the terminator behind the last line.
+            read_add_line ( pd, rofi_force_utf8_take ( g_strndup ( iter, end - iter ), end - iter ) );
+            iter = (char *) end;
+            break;
+        }
+        *sep = '\0';
+        if ( rofi_utf8_validate ( iter, sep - iter ) ) {
+            read_add_line ( pd, iter );
         }
         else {
-            g_error_free ( error );
+            read_add ( pd, iter, sep - iter );
         }
+        iter = sep + 1;
+    }
+    pd->map_offset = iter - pd->map;
+    return pd->map_offset == pd->map_length;
+}
+
+static void get_dmenu_mmap ( DmenuModePrivateData *pd )
+{
+    dmenu_mmap_split ( pd, G_MAXSIZE );
+    dmenu_index_start ( pd );
+}
+
+/**
+ * @param data The dmenu private data.
+ *
+ * Called when idle, splits the next block of the mapped input so a large file does not block the user interface.
+ *
+ * @returns G_SOURCE_REMOVE when the whole mapping is split.
+ */
+static gboolean dmenu_mmap_split_idle ( gpointer data )
+{
+    DmenuModePrivateData *pd  = (DmenuModePrivateData *) data;
+    gboolean             done = dmenu_mmap_split ( pd, DMENU_ASYNC_BUFFER_SIZE );
+    rofi_view_reload_append ();
+    if ( !done ) {
+        return G_SOURCE_CONTINUE;
+    }
+    pd->map_source = 0;
+    // Hack, don't use get active.
+    g_debug ( "Clearing overlay" );
+    rofi_view_set_overlay ( rofi_view_get_active (), NULL );
+    dmenu_index_start ( pd );
+    return G_SOURCE_REMOVE;
+}
+/**
+ * Called for each record split from the input.
+ * The record is terminated at data[len].
+ */
+typedef void ( *DmenuRecordFunc )( gpointer user_data, char *data, gsize len );
+
+/**
+ * @param separator The record separator.
+ * @param data      The buffer to split, data[len] should be writable.
+ * @param len       The number of bytes in data.
+ * @param func      Called for each complete record.
+ * @param user_data Passed to func.
+ *
+ * Split all complete records in data, memchr is vectorized in the common libc implementations.
+ *
+ * @returns the number of bytes consumed, the remainder is a partial record.
+ */
+static gsize dmenu_split_records ( char separator, char *data, gsize len, DmenuRecordFunc func, gpointer user_data )
+{
+    char       *iter = data;
+    const char *end  = data + len;
+    char       *sep;
+    while ( iter < end && ( sep = memchr ( iter, separator, end - iter ) ) != NULL ) {
+        *sep = '\0';
+        func ( user_data, iter, sep - iter );
+        iter = sep + 1;
+    }
+    return iter - data;
+}
+
+static void read_add_record ( gpointer user_data, char *data, gsize len )
+{
+    read_add ( (DmenuModePrivateData *) user_data, data, len );
+}
+
+static void async_read_callback ( GObject *source_object, GAsyncResult *res, gpointer user_data );
+
+/**
+ * @param pd The dmenu private data.
+ *
+ * Schedule the next read, behind the carried over partial record.
+ */
+static void async_read_next ( DmenuModePrivateData *pd )
+{
+    if ( pd->async_buffer_fill == pd->async_buffer_size ) {
+        // Single record larger than the buffer.
+        pd->async_buffer_size *= 2;
+        pd->async_buffer       = g_realloc ( pd->async_buffer, pd->async_buffer_size + 1 );
+    }
+    pd->async_read     = g_malloc0 ( sizeof ( DmenuAsyncRead ) );
+    pd->async_read->pd = pd;
+    g_input_stream_read_async ( G_INPUT_STREAM ( pd->data_input_stream ), pd->async_buffer + pd->async_buffer_fill,
+                                pd->async_buffer_size - pd->async_buffer_fill, G_PRIORITY_LOW, pd->cancel,
+                                async_read_callback, pd->async_read );
+}
+
+static void async_read_callback ( GObject *source_object, GAsyncResult *res, gpointer user_data )
+{
+    GInputStream         *stream = G_INPUT_STREAM ( source_object );
+    DmenuAsyncRead       *req    = (DmenuAsyncRead *) user_data;
+    DmenuModePrivateData *pd     = (DmenuModePrivateData *) req->pd;
+    GError               *error  = NULL;
+    gssize               len     = g_input_stream_read_finish ( stream, res, &error );
+    if ( pd == NULL ) {
+        // Freed during the read, the worker thread is done with the buffer now.
+        g_clear_error ( &error );
+        g_free ( req->buffer );
+        g_free ( req );
+        return;
+    }
+    g_free ( req );
+    pd->async_read = NULL;
+    if ( len > 0 ) {
+        pd->async_buffer_fill += len;
+        gsize used = dmenu_split_records ( pd->separator, pd->async_buffer, pd->async_buffer_fill, read_add_record, pd );
+        if ( used > 0 ) {
+            pd->async_buffer_fill -= used;
+            memmove ( pd->async_buffer, pd->async_buffer + used, pd->async_buffer_fill );
+            rofi_view_reload_append ();
+        }
+        async_read_next ( pd );
+        return;
     }
+    if ( error != NULL ) {
+        g_error_free ( error );
+    }
+    else if ( pd->async_buffer_fill > 0 ) {
+        // End of stream, add the unterminated last record.
+        pd->async_buffer[pd->async_buffer_fill] = '\0';
+        read_add ( pd, pd->async_buffer, pd->async_buffer_fill );
+        rofi_view_reload_append ();
+    }
+    g_free ( pd->async_buffer );
+    pd->async_buffer      = NULL;
+    pd->async_buffer_fill = 0;
     if ( !g_cancellable_is_cancelled ( pd->cancel ) ) {
         // Hack, don't use get active.
         g_debug ( "Clearing overlay" );
         rofi_view_set_overlay ( rofi_view_get_active (), NULL );
-        g_input_stream_close_async ( G_INPUT_STREAM ( stream ), G_PRIORITY_LOW, pd->cancel, async_close_callback, pd );
+        g_input_stream_close_async ( stream, G_PRIORITY_LOW, pd->cancel, async_close_callback, pd );
+        dmenu_index_start ( pd );
     }
 }
 
@@ -168,25 +426,249 @@ static void async_read_cancel ( G_GNUC_UNUSED GCancellable *cancel, G_GNUC_UNUSE
     g_debug ( "Cancelled the async read." );
 }
 
+static void read_block_add_record ( gpointer user_data, char *data, gsize len )
+{
+    g_ptr_array_add ( (GPtrArray *) user_data, rofi_force_utf8 ( data, len ) );
+}
+
+/**
+ * @param pd The dmenu private data.
+ *
+ * Wake the main thread to collect the published blocks, unless that is already pending.
+ * Only called from the reader thread.
+ */
+static void dmenu_reader_wakeup ( DmenuModePrivateData *pd )
+{
+    if ( g_atomic_int_compare_and_exchange ( &( pd->reader_wakeup ), FALSE, TRUE ) ) {
+        g_source_set_ready_time ( pd->reader_source, 0 );
+    }
+}
+
+/**
+ * @param pd    The dmenu private data.
+ * @param block The lines to hand over.
+ *
+ * Publish a block to the main thread, waits while the ring is full.
+ * Only called from the reader thread.
+ *
+ * @returns FALSE when the reader is cancelled, the block is then freed.
+ */
+static gboolean dmenu_reader_push ( DmenuModePrivateData *pd, GPtrArray *block )
+{
+    gint head = pd->reader_head;
+    g_mutex_lock ( &( pd->reader_mutex ) );
+    while ( ( head - g_atomic_int_get ( &( pd->reader_tail ) ) ) == DMENU_READER_RING_SIZE &&
+            !g_atomic_int_get ( &( pd->reader_cancel ) ) ) {
+        g_cond_wait ( &( pd->reader_cond ), &( pd->reader_mutex ) );
+    }
+    g_mutex_unlock ( &( pd->reader_mutex ) );
+    if ( g_atomic_int_get ( &( pd->reader_cancel ) ) ) {
+        g_ptr_array_free ( block, TRUE );
+        return FALSE;
+    }
+    pd->reader_ring[head % DMENU_READER_RING_SIZE] = block;
+    g_atomic_int_set ( &( pd->reader_head ), head + 1 );
+    dmenu_reader_wakeup ( pd );
+    return TRUE;
+}
+
+static gpointer dmenu_reader_thread ( gpointer data )
+{
+    DmenuModePrivateData *pd     = (DmenuModePrivateData *) data;
+    gsize                size    = DMENU_ASYNC_BUFFER_SIZE;
+    gsize                fill    = 0;
+    char                 *buffer = g_malloc ( size + 1 );
+    gboolean             run     = TRUE;
+    while ( run ) {
+        if ( fill == size ) {
+            // Single record larger than the buffer.
+            size  *= 2;
+            buffer = g_realloc ( buffer, size + 1 );
+        }
+        GPtrArray *block = g_ptr_array_new_with_free_func ( g_free );
+        gssize    len    = g_input_stream_read ( G_INPUT_STREAM ( pd->data_input_stream ), buffer + fill, size - fill, pd->cancel, NULL );
+        if ( len > 0 ) {
+            fill += len;
+            gsize used = dmenu_split_records ( pd->separator, buffer, fill, read_block_add_record, block );
+            fill -= used;
+            memmove ( buffer, buffer + used, fill );
+        }
+        else {
+            if ( len == 0 && fill > 0 ) {
+                // End of stream, add the unterminated last record.
+                buffer[fill] = '\0';
+                read_block_add_record ( block, buffer, fill );
+            }
+            run = FALSE;
+        }
+        if ( block->len == 0 ) {
+            g_ptr_array_free ( block, TRUE );
+        }
+        else if ( !dmenu_reader_push ( pd, block ) ) {
+            run = FALSE;
+        }
+    }
+    g_free ( buffer );
+    g_atomic_int_set ( &( pd->reader_done ), TRUE );
+    dmenu_reader_wakeup ( pd );
+    return NULL;
+}
+
+/**
+ * @param data The dmenu private data.
+ *
+ * Called on the main thread when the reader woke it, appends the published blocks to the list.
+ *
+ * @returns G_SOURCE_REMOVE when the reader is done.
+ */
+static gboolean dmenu_reader_collect ( gpointer data )
+{
+    DmenuModePrivateData *pd = (DmenuModePrivateData *) data;
+    // Clear before looking at the head, a block published after this wakes us again.
+    g_atomic_int_set ( &( pd->reader_wakeup ), FALSE );
+    // Check done before the head, so the last block is seen.
+    gboolean             done = g_atomic_int_get ( &( pd->reader_done ) );
+    gint                 head = g_atomic_int_get ( &( pd->reader_head ) );
+    if ( pd->reader_tail != head ) {
+        for ( gint tail = pd->reader_tail; tail != head; tail++ ) {
+            GPtrArray *block = pd->reader_ring[tail % DMENU_READER_RING_SIZE];
+            for ( guint i = 0; i < block->len; i++ ) {
+                read_add_line ( pd, g_ptr_array_index ( block, i ) );
+            }
+            // The lines moved to the list.
+            g_ptr_array_set_free_func ( block, NULL );
+            g_ptr_array_free ( block, TRUE );
+            g_atomic_int_set ( &( pd->reader_tail ), tail + 1 );
+        }
+        // There is room in the ring again.
+        g_mutex_lock ( &( pd->reader_mutex ) );
+        g_cond_signal ( &( pd->reader_cond ) );
+        g_mutex_unlock ( &( pd->reader_mutex ) );
+        rofi_view_reload_append ();
+    }
+    if ( !done ) {
+        return G_SOURCE_CONTINUE;
+    }
+    g_thread_join ( pd->reader_thread );
+    pd->reader_thread = NULL;
+    // Hack, don't use get active.
+    g_debug ( "Clearing overlay" );
+    rofi_view_set_overlay ( rofi_view_get_active (), NULL );
+    g_input_stream_close_async ( G_INPUT_STREAM ( pd->input_stream ), G_PRIORITY_LOW, pd->cancel, async_close_callback, pd );
+    dmenu_index_start ( pd );
+    return G_SOURCE_REMOVE;
+}
+
+/**
+ * @param pd The dmenu private data.
+ *
+ * Stop the reader thread and free the blocks not yet collected.
+ */
+static void dmenu_reader_stop ( DmenuModePrivateData *pd )
+{
+    if ( pd->reader_thread != NULL ) {
+        g_atomic_int_set ( &( pd->reader_cancel ), TRUE );
+        g_mutex_lock ( &( pd->reader_mutex ) );
+        g_cond_signal ( &( pd->reader_cond ) );
+        g_mutex_unlock ( &( pd->reader_mutex ) );
+        g_cancellable_cancel ( pd->cancel );
+        g_thread_join ( pd->reader_thread );
+        pd->reader_thread = NULL;
+        for ( gint tail = pd->reader_tail; tail != pd->reader_head; tail++ ) {
+            g_ptr_array_free ( pd->reader_ring[tail % DMENU_READER_RING_SIZE], TRUE );
+        }
+        pd->reader_tail = pd->reader_head;
+    }
+    // The reader uses the source, so only after it stopped.
+    if ( pd->reader_source != NULL ) {
+        g_source_destroy ( pd->reader_source );
+        g_source_unref ( pd->reader_source );
+        pd->reader_source = NULL;
+        g_cond_clear ( &( pd->reader_cond ) );
+        g_mutex_clear ( &( pd->reader_mutex ) );
+    }
+}
+
+static gboolean dmenu_reader_source_dispatch ( GSource *source, GSourceFunc callback, gpointer user_data )
+{
+    // Wait for the next wake up.
+    g_source_set_ready_time ( source, -1 );
+    return callback ( user_data );
+}
+
+/** Source that is only dispatched when its ready time is set by the reader. */
+static GSourceFuncs dmenu_reader_source_funcs = {
+    .dispatch = dmenu_reader_source_dispatch,
+};
+
+/**
+ * @param pd The dmenu private data.
+ *
+ * Read the rest of the input on a separate thread, so splitting and validating
+ * the lines does not compete with the user interface.
+ *
+ * @returns TRUE when the thread is running.
+ */
+static gboolean dmenu_reader_start ( DmenuModePrivateData *pd )
+{
+    GError *error = NULL;
+    g_mutex_init ( &( pd->reader_mutex ) );
+    g_cond_init ( &( pd->reader_cond ) );
+    pd->reader_source = g_source_new ( &dmenu_reader_source_funcs, sizeof ( GSource ) );
+    g_source_set_callback ( pd->reader_source, dmenu_reader_collect, pd, NULL );
+    g_source_attach ( pd->reader_source, NULL );
+    pd->reader_thread = g_thread_try_new ( "dmenu-reader", dmenu_reader_thread, pd, &error );
+    if ( error != NULL ) {
+        g_warning ( "Failed to start reader thread: %s", error->message );
+        g_error_free ( error );
+        dmenu_reader_stop ( pd );
+        return FALSE;
+    }
+    return TRUE;
+}
+
 static int get_dmenu_async ( DmenuModePrivateData *pd, int sync_pre_read )
 {
+    if ( pd->map != NULL ) {
+        // One line per step.
+        gboolean done = FALSE;
+        while ( sync_pre_read-- && !done ) {
+            done = dmenu_mmap_split ( pd, 1 );
+        }
+        if ( done ) {
+            dmenu_index_start ( pd );
+            return FALSE;
+        }
+        pd->map_source = g_idle_add_full ( G_PRIORITY_LOW, dmenu_mmap_split_idle, pd, NULL );
+        return TRUE;
+    }
     while ( sync_pre_read-- ) {
         gsize len   = 0;
         char  *data = g_data_input_stream_read_upto ( pd->data_input_stream, &( pd->separator ), 1, &len, NULL, NULL );
         if ( data == NULL ) {
             g_input_stream_close_async ( G_INPUT_STREAM ( pd->input_stream ), G_PRIORITY_LOW, pd->cancel, async_close_callback, pd );
+            dmenu_index_start ( pd );
             return FALSE;
         }
         g_data_input_stream_read_byte ( pd->data_input_stream, NULL, NULL );
-        read_add ( pd, data, len );
-        g_free ( data );
+        read_add_line ( pd, rofi_force_utf8_take ( data, len ) );
     }
-    g_data_input_stream_read_upto_async ( pd->data_input_stream, &( pd->separator ), 1, G_PRIORITY_LOW, pd->cancel,
-                                          async_read_callback, pd );
+    if ( find_arg ( "-async-read-thread" ) >= 0 && dmenu_reader_start ( pd ) ) {
+        return TRUE;
+    }
+    // Read the rest in large blocks, data already buffered by the data stream comes first.
+    pd->async_buffer_size = DMENU_ASYNC_BUFFER_SIZE;
+    pd->async_buffer      = g_malloc ( pd->async_buffer_size + 1 );
+    pd->async_buffer_fill = 0;
+    async_read_next ( pd );
     return TRUE;
 }
 static void get_dmenu_sync ( DmenuModePrivateData *pd )
 {
+    if ( pd->map != NULL ) {
+        get_dmenu_mmap ( pd );
+        return;
+    }
     while  ( TRUE ) {
         gsize len   = 0;
         char  *data = g_data_input_stream_read_upto ( pd->data_input_stream, &( pd->separator ), 1, &len, NULL, NULL );
@@ -194,10 +676,10 @@ static void get_dmenu_sync ( DmenuModePrivateData *pd )
             break;
         }
         g_data_input_stream_read_byte ( pd->data_input_stream, NULL, NULL );
-        read_add ( pd, data, len );
-        g_free ( data );
+        read_add_line ( pd, rofi_force_utf8_take ( data, len ) );
     }
     g_input_stream_close_async ( G_INPUT_STREAM ( pd->input_stream ), G_PRIORITY_LOW, pd->cancel, async_close_callback, pd );
+    dmenu_index_start ( pd );
 }
 
 static unsigned int dmenu_mode_get_num_entries ( const Mode *sw )
@@ -357,6 +839,12 @@ static void dmenu_mode_free ( Mode *sw )
     }
     DmenuModePrivateData *pd = (DmenuModePrivateData *) mode_get_private_data ( sw );
     if ( pd != NULL ) {
+        // The reader thread uses the stream, stop it first.
+        dmenu_reader_stop ( pd );
+        if ( pd->map_source != 0 ) {
+            g_source_remove ( pd->map_source );
+            pd->map_source = 0;
+        }
         if ( pd->cancel  ) {
             // If open, cancel reads.
             if ( pd->input_stream && !g_input_stream_is_closed ( pd->input_stream ) ) {
@@ -371,13 +859,29 @@ static void dmenu_mode_free ( Mode *sw )
             }
             g_object_unref ( pd->cancel );
         }
+        if ( pd->async_read != NULL ) {
+            // The cancelled read can still write into the buffer, async_read_callback() frees it.
+            pd->async_read->pd     = NULL;
+            pd->async_read->buffer = pd->async_buffer;
+            pd->async_buffer       = NULL;
+        }
+        if ( pd->index_thread != NULL ) {
+            // The index references the lines, stop it first.
+            g_atomic_int_set ( &( pd->index_cancel ), TRUE );
+            g_thread_join ( pd->index_thread );
+        }
+        helper_trigram_index_free ( pd->index );
+        g_free ( pd->async_buffer );
 
         for ( size_t i = 0; i < pd->cmd_list_length; i++ ) {
-            if ( pd->cmd_list[i] ) {
+            if ( pd->cmd_list[i] && !dmenu_line_is_mapped ( pd, pd->cmd_list[i] ) ) {
                 free ( pd->cmd_list[i] );
             }
         }
         g_free ( pd->cmd_list );
+        if ( pd->map != NULL ) {
+            munmap ( pd->map, pd->map_length );
+        }
         g_free ( pd->urgent_list );
         g_free ( pd->active_list );
         g_free ( pd->selected_list );
@@ -404,6 +908,9 @@ static int dmenu_mode_init ( Mode *sw )
     find_arg_char ( "-sep", &( pd->separator ) );
 
     find_arg_uint (  "-selected-row", &( pd->selected_line ) );
+    // Trigram index, 0 disables it.
+    pd->index_min_lines = DMENU_INDEX_MIN_LINES;
+    find_arg_uint (  "-index-min-lines", &( pd->index_min_lines ) );
     // By default we print the unescaped line back.
     pd->format = "s";
 
@@ -450,11 +957,18 @@ static int dmenu_mode_init ( Mode *sw )
             return TRUE;
         }
         g_free ( estr );
+        if ( dmenu_mmap_input ( pd, fd ) ) {
+            // The mapping stays valid after closing.
+            close ( fd );
+            fd = -1;
+        }
+    }
+    pd->cancel        = g_cancellable_new ();
+    pd->cancel_source = g_cancellable_connect ( pd->cancel, G_CALLBACK ( async_read_cancel ), pd, NULL );
+    if ( fd >= 0 ) {
+        pd->input_stream      = g_unix_input_stream_new ( fd, fd != STDIN_FILENO );
+        pd->data_input_stream = g_data_input_stream_new ( pd->input_stream );
     }
-    pd->cancel            = g_cancellable_new ();
-    pd->cancel_source     = g_cancellable_connect ( pd->cancel, G_CALLBACK ( async_read_cancel ), pd, NULL );
-    pd->input_stream      = g_unix_input_stream_new ( fd, fd != STDIN_FILENO );
-    pd->data_input_stream = g_data_input_stream_new ( pd->input_stream );
 
     gchar *columns = NULL;
     if ( find_arg_str ( "-display-columns", &columns ) ) {
@@ -465,11 +979,35 @@ static int dmenu_mode_init ( Mode *sw )
     return TRUE;
 }
 
-static int dmenu_token_match ( const Mode *sw, GRegex **tokens, unsigned int index )
+static int dmenu_token_match ( const Mode *sw, rofi_int_matcher **tokens, unsigned int index )
 {
     DmenuModePrivateData *rmpd = (DmenuModePrivateData *) mode_get_private_data ( sw );
     return helper_token_match ( tokens, rmpd->cmd_list[index] );
 }
+static unsigned int *dmenu_get_candidates ( const Mode *sw, rofi_int_matcher **tokens, unsigned int *length )
+{
+    DmenuModePrivateData *rmpd  = (DmenuModePrivateData *) mode_get_private_data ( sw );
+    RofiTrigramIndex     *index = g_atomic_pointer_get ( &( rmpd->index ) );
+    if ( index == NULL ) {
+        // Not (yet) indexed, check all entries.
+        return NULL;
+    }
+    return helper_trigram_index_query ( index, tokens, length );
+}
+static guint64 dmenu_get_signature ( const Mode *sw, unsigned int index )
+{
+    DmenuModePrivateData *rmpd = (DmenuModePrivateData *) mode_get_private_data ( sw );
+    return helper_token_match_signature ( rmpd->cmd_list[index] );
+}
+static const char *dmenu_get_completion_string ( const Mode *sw, unsigned int index )
+{
+    DmenuModePrivateData *rmpd = (DmenuModePrivateData *) mode_get_private_data ( sw );
+    if ( rmpd->columns != NULL ) {
+        // The completion is built from the selected columns.
+        return NULL;
+    }
+    return rmpd->cmd_list[index];
+}
 static char *dmenu_get_message ( const Mode *sw )
 {
     DmenuModePrivateData *pd = (DmenuModePrivateData *) mode_get_private_data ( sw );
@@ -494,6 +1032,9 @@ Mode dmenu_mode =
     ._get_completion    = NULL,
     ._preprocess_input  = NULL,
     ._get_message       = dmenu_get_message,
+    ._get_signature     = dmenu_get_signature,
+    ._get_candidates    = dmenu_get_candidates,
+    ._get_completion_string = dmenu_get_completion_string,
     .private_data       = NULL,
     .free               = NULL,
     .display_name       = "dmenu:"
@@ -682,8 +1223,8 @@ int dmenu_switcher_dialog ( void )
     char *select = NULL;
     find_arg_str ( "-select", &select );
     if ( select != NULL ) {
-        GRegex       **tokens = tokenize ( select, config.case_sensitive );
-        unsigned int i        = 0;
+        rofi_int_matcher **tokens = tokenize ( select, config.case_sensitive );
+        unsigned int     i        = 0;
         for ( i = 0; i < cmd_list_length; i++ ) {
             if ( helper_token_match ( tokens, cmd_list[i] ) ) {
                 pd->selected_line = i;
@@ -693,8 +1234,8 @@ int dmenu_switcher_dialog ( void )
         tokenize_free ( tokens );
     }
     if ( find_arg ( "-dump" ) >= 0 ) {
-        GRegex       **tokens = tokenize ( config.filter ? config.filter : "", config.case_sensitive );
-        unsigned int i        = 0;
+        rofi_int_matcher **tokens = tokenize ( config.filter ? config.filter : "", config.case_sensitive );
+        unsigned int     i        = 0;
         for ( i = 0; i < cmd_list_length; i++ ) {
             if ( tokens == NULL || helper_token_match ( tokens, cmd_list[i] ) ) {
                 dmenu_output_formatted_line ( pd->format, cmd_list[i], i, config.filter );
@@ -737,4 +1278,6 @@ void print_dmenu_options ( void )
     print_help_msg ( "-input", "[filename]", "Read input from file instead from standard input.", NULL, is_term );
     print_help_msg ( "-sync", "", "Force dmenu to first read all input data, then show dialog.", NULL, is_term );
     print_help_msg ( "-async-pre-read", "[number]", "Read several entries blocking before switching to async mode", "25", is_term );
+    print_help_msg ( "-index-min-lines", "[number]", "Index inputs with at least this many lines for faster filtering, 0 disables.", "100000", is_term );
+    print_help_msg ( "-async-read-thread", "", "Read and split the input on a separate thread in async mode.", NULL, is_term );
 }
@@ -509,52 +509,65 @@ static char *drun_get_completion ( const Mode *sw, unsigned int index )
         return g_strdup_printf ( "%s", dr->name );
     }
 }
+static const char *drun_get_completion_string ( const Mode *sw, unsigned int index )
+{
+    DRunModePrivateData *pd = (DRunModePrivateData *) mode_get_private_data ( sw );
+    return pd->entry_list[index].name;
+}
 
-static int drun_token_match ( const Mode *data, GRegex **tokens, unsigned int index )
+static int drun_token_match ( const Mode *data, rofi_int_matcher **tokens, unsigned int index )
 {
     DRunModePrivateData *rmpd = (DRunModePrivateData *) mode_get_private_data ( data );
-    int                 match = 1;
-    if ( tokens ) {
-        for ( int j = 0; match && tokens != NULL && tokens[j] != NULL; j++ ) {
-            int    test        = 0;
-            GRegex *ftokens[2] = { tokens[j], NULL };
-            // Match name
-            if ( rmpd->entry_list[index].name &&
-                 helper_token_match ( ftokens, rmpd->entry_list[index].name ) ) {
-                test = 1;
-            }
-            // Match generic name
-            if ( !test && rmpd->entry_list[index].generic_name &&
-                 helper_token_match ( ftokens, rmpd->entry_list[index].generic_name ) ) {
-                test = 1;
-            }
-            // Match executable name.
-            if ( !test && helper_token_match ( ftokens, rmpd->entry_list[index].exec ) ) {
-                test = 1;
-            }
-            // Match against category.
-            if ( !test ) {
+    if ( tokens == NULL ) {
+        return 1;
+    }
+    // Match name, generic name, executable name and the categories.
 #ifdef GET_CAT_PARSE_TIME
-                gchar **list = rmpd->entry_list[index].categories;
-                for ( int iter = 0; !test && list && list[iter]; iter++ ) {
-                    test = helper_token_match ( ftokens, list[iter] );
-                }
+    gchar        **list = rmpd->entry_list[index].categories;
 #else
-                gchar **list = g_key_file_get_locale_string_list ( rmpd->entry_list[index].key_file, "Desktop Entry", "Categories", NULL, NULL, NULL );
-                for ( int iter = 0; !test && list && list[iter]; iter++ ) {
-                    test = helper_token_match ( ftokens, list[iter] );
-                }
-                g_strfreev ( list );
+    gchar        **list = g_key_file_get_locale_string_list ( rmpd->entry_list[index].key_file, "Desktop Entry", "Categories", NULL, NULL, NULL );
+#endif
+    unsigned int num_fields = 3 + ( list ? g_strv_length ( list ) : 0 );
+    const char   **fields   = g_newa ( const char *, num_fields );
+    fields[0] = rmpd->entry_list[index].name;
+    fields[1] = rmpd->entry_list[index].generic_name;
+    fields[2] = rmpd->entry_list[index].exec;
+    for ( unsigned int iter = 3; iter < num_fields; iter++ ) {
+        fields[iter] = list[iter - 3];
+    }
+    int          match = helper_token_match_fields ( tokens, fields, num_fields );
+#ifndef GET_CAT_PARSE_TIME
+    g_strfreev ( list );
 #endif
-            }
-            if ( test == 0 ) {
-                match = 0;
-            }
-        }
-    }
     return match;
 }
 
+static guint64 drun_get_signature ( const Mode *sw, unsigned int index )
+{
+    DRunModePrivateData *rmpd = (DRunModePrivateData *) mode_get_private_data ( sw );
+    // Same fields as drun_token_match.
+    guint64             signature = helper_token_match_signature ( rmpd->entry_list[index].exec );
+    if ( rmpd->entry_list[index].name ) {
+        signature |= helper_token_match_signature ( rmpd->entry_list[index].name );
+    }
+    if ( rmpd->entry_list[index].generic_name ) {
+        signature |= helper_token_match_signature ( rmpd->entry_list[index].generic_name );
+    }
+#ifdef GET_CAT_PARSE_TIME
+    gchar **list = rmpd->entry_list[index].categories;
+    for ( int iter = 0; list && list[iter]; iter++ ) {
+        signature |= helper_token_match_signature ( list[iter] );
+    }
+#else
+    gchar **list = g_key_file_get_locale_string_list ( rmpd->entry_list[index].key_file, "Desktop Entry", "Categories", NULL, NULL, NULL );
+    for ( int iter = 0; list && list[iter]; iter++ ) {
+        signature |= helper_token_match_signature ( list[iter] );
+    }
+    g_strfreev ( list );
+#endif
+    return signature;
+}
+
 static unsigned int drun_mode_get_num_entries ( const Mode *sw )
 {
     const DRunModePrivateData *pd = (const DRunModePrivateData *) mode_get_private_data ( sw );
@@ -570,7 +583,9 @@ Mode drun_mode =
     ._result            = drun_mode_result,
     ._destroy           = drun_mode_destroy,
     ._token_match       = drun_token_match,
+    ._get_signature     = drun_get_signature,
     ._get_completion    = drun_get_completion,
+    ._get_completion_string = drun_get_completion_string,
     ._get_display_value = _get_display_value,
     ._preprocess_input  = NULL,
     .private_data       = NULL,
@@ -398,11 +398,21 @@ static char *_get_display_value ( const Mode *sw, unsigned int selected_line, G_
     const RunModePrivateData *rmpd = (const RunModePrivateData *) sw->private_data;
     return get_entry ? g_strdup ( rmpd->cmd_list[selected_line] ) : NULL;
 }
-static int run_token_match ( const Mode *sw, GRegex **tokens, unsigned int index )
+static int run_token_match ( const Mode *sw, rofi_int_matcher **tokens, unsigned int index )
 {
     const RunModePrivateData *rmpd = (const RunModePrivateData *) sw->private_data;
     return helper_token_match ( tokens, rmpd->cmd_list[index] );
 }
+static guint64 run_get_signature ( const Mode *sw, unsigned int index )
+{
+    const RunModePrivateData *rmpd = (const RunModePrivateData *) sw->private_data;
+    return helper_token_match_signature ( rmpd->cmd_list[index] );
+}
+static const char *run_get_completion_string ( const Mode *sw, unsigned int index )
+{
+    const RunModePrivateData *rmpd = (const RunModePrivateData *) sw->private_data;
+    return rmpd->cmd_list[index];
+}
 
 #include "mode-private.h"
 Mode run_mode =
@@ -414,8 +424,10 @@ Mode run_mode =
     ._result            = run_mode_result,
     ._destroy           = run_mode_destroy,
     ._token_match       = run_token_match,
+    ._get_signature     = run_get_signature,
     ._get_display_value = _get_display_value,
     ._get_completion    = NULL,
+    ._get_completion_string = run_get_completion_string,
     ._preprocess_input  = NULL,
     .private_data       = NULL,
     .free               = NULL
@@ -521,11 +521,21 @@ static char *_get_display_value ( const Mode *sw, unsigned int selected_line, G_
  *
  * @returns TRUE if matches
  */
-static int ssh_token_match ( const Mode *sw, GRegex **tokens, unsigned int index )
+static int ssh_token_match ( const Mode *sw, rofi_int_matcher **tokens, unsigned int index )
 {
     SSHModePrivateData *rmpd = (SSHModePrivateData *) mode_get_private_data ( sw );
     return helper_token_match ( tokens, rmpd->hosts_list[index] );
 }
+static guint64 ssh_get_signature ( const Mode *sw, unsigned int index )
+{
+    SSHModePrivateData *rmpd = (SSHModePrivateData *) mode_get_private_data ( sw );
+    return helper_token_match_signature ( rmpd->hosts_list[index] );
+}
+static const char *ssh_get_completion_string ( const Mode *sw, unsigned int index )
+{
+    SSHModePrivateData *rmpd = (SSHModePrivateData *) mode_get_private_data ( sw );
+    return rmpd->hosts_list[index];
+}
 #include "mode-private.h"
 Mode ssh_mode =
 {
@@ -536,8 +546,10 @@ Mode ssh_mode =
     ._result            = ssh_mode_result,
     ._destroy           = ssh_mode_destroy,
     ._token_match       = ssh_token_match,
+    ._get_signature     = ssh_get_signature,
     ._get_display_value = _get_display_value,
     ._get_completion    = NULL,
+    ._get_completion_string = ssh_get_completion_string,
     ._preprocess_input  = NULL,
     .private_data       = NULL,
     .free               = NULL
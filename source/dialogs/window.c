@@ -321,7 +321,7 @@ static client* window_client ( ModeModePrivateData *pd, xcb_window_t win )
     g_free ( attr );
     return c;
 }
-static int window_match ( const Mode *sw, GRegex **tokens, unsigned int index )
+static int window_match ( const Mode *sw, rofi_int_matcher **tokens, unsigned int index )
 {
     ModeModePrivateData *rmpd = (ModeModePrivateData *) mode_get_private_data ( sw );
     int                 match = 1;
@@ -332,41 +332,36 @@ static int window_match ( const Mode *sw, GRegex **tokens, unsigned int index )
     client              *c = cache_client->data[idx];
 
     if ( tokens ) {
-        for ( int j = 0; match && tokens != NULL && tokens[j] != NULL; j++ ) {
-            int test = 0;
-            // Dirty hack. Normally helper_token_match does _all_ the matching,
-            // Now we want it to match only one item at the time.
-            // If hack not in place it would not match queries spanning multiple fields.
-            // e.g. when searching 'title element' and 'class element'
-            GRegex *ftokens[2] = { tokens[j], NULL };
-            if ( c->title != NULL && c->title[0] != '\0' ) {
-                test = helper_token_match ( ftokens, c->title );
-            }
-
-            if ( !test && c->class != NULL && c->class[0] != '\0' ) {
-                test = helper_token_match ( ftokens, c->class );
-            }
-
-            if ( !test && c->role != NULL && c->role[0] != '\0' ) {
-                test = helper_token_match ( ftokens, c->role );
-            }
-
-            if ( !test && c->name != NULL && c->name[0] != '\0' ) {
-                test = helper_token_match ( ftokens, c->name );
-            }
-            if ( !test && c->wmdesktopstr != NULL && c->wmdesktopstr[0] != '\0' ) {
-                test = helper_token_match ( ftokens, c->wmdesktopstr );
-            }
-
-            if ( test == 0 ) {
-                match = 0;
-            }
-        }
+        // Each token can match any of the fields, so queries can span multiple fields.
+        // e.g. when searching 'title element' and 'class element'
+        const char * const fields[] = {
+            ( c->title != NULL && c->title[0] != '\0' ) ? c->title : NULL,
+            ( c->class != NULL && c->class[0] != '\0' ) ? c->class : NULL,
+            ( c->role != NULL && c->role[0] != '\0' ) ? c->role : NULL,
+            ( c->name != NULL && c->name[0] != '\0' ) ? c->name : NULL,
+            ( c->wmdesktopstr != NULL && c->wmdesktopstr[0] != '\0' ) ? c->wmdesktopstr : NULL,
+        };
+        match = helper_token_match_fields ( tokens, fields, G_N_ELEMENTS ( fields ) );
     }
 
     return match;
 }
 
+static guint64 window_get_signature ( const Mode *sw, unsigned int index )
+{
+    ModeModePrivateData *rmpd = (ModeModePrivateData *) mode_get_private_data ( sw );
+    const winlist       *ids  = ( winlist * ) rmpd->ids;
+    int                 idx   = winlist_find ( cache_client, ids->array[index] );
+    g_assert ( idx >= 0 );
+    client              *c = cache_client->data[idx];
+    // Same fields as window_match.
+    return helper_token_match_signature ( c->title ) |
+           helper_token_match_signature ( c->class ) |
+           helper_token_match_signature ( c->role ) |
+           helper_token_match_signature ( c->name ) |
+           helper_token_match_signature ( c->wmdesktopstr );
+}
+
 static unsigned int window_mode_get_num_entries ( const Mode *sw )
 {
     const ModeModePrivateData *pd = (const ModeModePrivateData *) mode_get_private_data ( sw );
@@ -736,6 +731,7 @@ Mode window_mode =
     ._result            = window_mode_result,
     ._destroy           = window_mode_destroy,
     ._token_match       = window_match,
+    ._get_signature     = window_get_signature,
     ._get_display_value = _get_display_value,
     ._get_completion    = NULL,
     ._preprocess_input  = NULL,
@@ -751,6 +747,7 @@ Mode window_mode_cd =
     ._result            = window_mode_result,
     ._destroy           = window_mode_destroy,
     ._token_match       = window_match,
+    ._get_signature     = window_get_signature,
     ._get_display_value = _get_display_value,
     ._get_completion    = NULL,
     ._preprocess_input  = NULL,
@@ -47,6 +47,9 @@
 #include <pango/pango.h>
 #include <pango/pango-fontmap.h>
 #include <pango/pangocairo.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 #include "helper.h"
 #include "helper-theme.h"
 #include "settings.h"
@@ -151,10 +154,63 @@ int helper_parse_setup ( char * string, char ***output, int *length, ... )
     return FALSE;
 }
 
-void tokenize_free ( GRegex ** tokens )
+/** Maximum number of literal tokens in a #RofiLiteralSet, one bit each. */
+#define LITERAL_SET_MAX_TOKENS    64
+
+/**
+ * Aho-Corasick automaton over the needles of the literal tokens of a query.
+ * The goto and failure functions are merged into a full transition table, so
+ * scanning an entry is a single table lookup per byte.
+ */
+struct _RofiLiteralSet
+{
+    /** Input class of each byte, bytes not in any needle share class 0. */
+    guint8                  classes[256];
+    /** Number of input classes. */
+    unsigned int            num_classes;
+    /** Transition table, num_classes entries per state. State 0 is the root. */
+    unsigned int            *delta;
+    /** The bits of the tokens found on entering each state. */
+    guint64                 *out;
+    /** The bits of all tokens in the set. */
+    guint64                 all;
+    /** The token array the set was built for. */
+    rofi_int_matcher *const *tokens;
+};
+
+static void rofi_literal_set_free ( RofiLiteralSet *set )
+{
+    if ( set == NULL ) {
+        return;
+    }
+    g_free ( set->delta );
+    g_free ( set->out );
+    g_free ( set );
+}
+
+static void rofi_int_matcher_free ( rofi_int_matcher *rm )
+{
+    if ( rm == NULL ) {
+        return;
+    }
+    rofi_literal_set_free ( rm->literals );
+    if ( rm->regex ) {
+        g_regex_unref ( rm->regex );
+    }
+    g_free ( rm->needle );
+    g_free ( rm->uneedle );
+    g_free ( rm->accept );
+    for ( unsigned int i = 0; i < rm->num_segments; i++ ) {
+        g_free ( rm->segments[i].uchars );
+    }
+    g_free ( rm->segments );
+    g_free ( rm );
+}
+
+void tokenize_free ( rofi_int_matcher ** tokens )
 {
     for ( size_t i = 0; tokens && tokens[i]; i++ ) {
-        g_regex_unref ( (GRegex *) tokens[i] );
+        rofi_int_matcher_free ( tokens[i] );
     }
     g_free ( tokens );
 }
@@ -176,76 +232,338 @@ static gchar *glob_to_regex ( const char *input )
     }
     return r;
 }
-static gchar *fuzzy_to_regex ( const char * input )
+// Macro for quickly generating regex for matching.
+static inline GRegex * R ( const char *s, int case_sensitive  )
 {
-    GString *str = g_string_new ( "" );
-    gchar   *r   = g_regex_escape_string ( input, -1 );
-    gchar   *iter;
-    int     first = 1;
-    for ( iter = r; iter && *iter != '\0'; iter = g_utf8_next_char ( iter ) ) {
-        if ( first ) {
-            g_string_append ( str, "(" );
+    return g_regex_new ( s, G_REGEX_OPTIMIZE | ( ( case_sensitive ) ? 0 : G_REGEX_CASELESS ), 0, NULL );
+}
+
+/**
+ * @param c The character.
+ *
+ * Map the (lower-cased) character on a bit in the signature.
+ * Letters and digits get their own bit, other characters share one.
+ *
+ * @returns the bit for c, 0 for white-space and control characters.
+ */
+static guint64 helper_signature_bit ( gunichar c )
+{
+    if ( c < 0x80 ) {
+        c = g_ascii_tolower ( c );
+        if ( c >= 'a' && c <= 'z' ) {
+            return G_GUINT64_CONSTANT ( 1 ) << ( c - 'a' );
+        }
+        if ( c >= '0' && c <= '9' ) {
+            return G_GUINT64_CONSTANT ( 1 ) << ( 26 + c - '0' );
+        }
+        if ( c <= ' ' || c == 0x7F ) {
+            return 0;
+        }
+        return G_GUINT64_CONSTANT ( 1 ) << ( 36 + c % 16 );
+    }
+    c = g_unichar_tolower ( c );
+    if ( c < 0x80 ) {
+        return helper_signature_bit ( c );
+    }
+    return G_GUINT64_CONSTANT ( 1 ) << ( 52 + c % 11 );
+}
+
+guint64 helper_token_match_signature ( const char *input )
+{
+    guint64 signature = ROFI_SIGNATURE_COMPUTED;
+    if ( input == NULL ) {
+        return signature;
+    }
+    for ( const char *iter = input; *iter != '\0'; ) {
+        if ( (unsigned char) *iter < 0x80 ) {
+            signature |= helper_signature_bit ( *iter );
+            iter++;
         }
         else {
-            g_string_append ( str, ".*(" );
+            signature |= helper_signature_bit ( g_utf8_get_char ( iter ) );
+            iter       = g_utf8_next_char ( iter );
         }
-        if ( *iter == '\\' ) {
-            g_string_append_c ( str, '\\' );
-            iter = g_utf8_next_char ( iter );
-            // If EOL, break out of for loop.
-            if ( ( *iter ) == '\0' ) {
-                break;
+    }
+    return signature;
+}
+
+guint64 helper_tokens_signature ( rofi_int_matcher * const *tokens )
+{
+    guint64 signature = 0;
+    for ( int j = 0; tokens != NULL && tokens[j] != NULL; j++ ) {
+        signature |= tokens[j]->signature;
+    }
+    return signature;
+}
+
+/**
+ * @param type  The type of matcher to create.
+ * @param input The string to match.
+ * @param case_sensitive Whether case is significant.
+ *
+ * Create a matcher that works on the needle directly. When not case sensitive the needle is lower-cased
+ * once here, so matching only has to fold the haystack.
+ *
+ * @returns a newly allocated matcher.
+ */
+static rofi_int_matcher * create_needle_matcher ( RofiMatcherType type, const char *input, int case_sensitive )
+{
+    rofi_int_matcher *rm = g_malloc0 ( sizeof ( rofi_int_matcher ) );
+    rm->type           = type;
+    rm->case_sensitive = case_sensitive;
+    rm->needle         = g_strdup ( input );
+    rm->needle_len     = strlen ( input );
+    rm->uneedle        = g_utf8_to_ucs4_fast ( input, -1, &( rm->uneedle_len ) );
+    rm->ascii          = TRUE;
+    for ( size_t i = 0; i < rm->needle_len; i++ ) {
+        if ( (unsigned char) rm->needle[i] >= 0x80 ) {
+            rm->ascii = FALSE;
+        }
+        else if ( !case_sensitive ) {
+            rm->needle[i] = g_ascii_tolower ( rm->needle[i] );
+        }
+    }
+    for ( glong i = 0; i < rm->uneedle_len; i++ ) {
+        if ( !case_sensitive ) {
+            rm->uneedle[i] = g_unichar_tolower ( rm->uneedle[i] );
+        }
+        rm->signature |= helper_signature_bit ( rm->uneedle[i] );
+    }
+    if ( type == ROFI_MATCHER_FUZZY && rm->ascii ) {
+        // For each character: both cases and the newline, as a match cannot span lines.
+        rm->accept = g_malloc0 ( rm->needle_len * 4 );
+        for ( size_t i = 0; i < rm->needle_len; i++ ) {
+            rm->accept[i * 4]     = rm->needle[i];
+            rm->accept[i * 4 + 1] = case_sensitive ? rm->needle[i] : g_ascii_toupper ( rm->needle[i] );
+            rm->accept[i * 4 + 2] = '\n';
+        }
+    }
+    return rm;
+}
+
+/**
+ * @param input The glob pattern.
+ * @param case_sensitive Whether case is significant.
+ *
+ * Compile a glob pattern. The pattern is split on '*' and each segment is compiled into a shift-and automaton.
+ * A '?' matches one non white-space character (like the '\\S' the regex version used).
+ *
+ * @returns a newly allocated glob matcher, or NULL when a segment is too long.
+ */
+static rofi_int_matcher * create_glob_matcher ( const char *input, int case_sensitive )
+{
+    glong            len    = 0;
+    gunichar         *chars = g_utf8_to_ucs4_fast ( input, -1, &len );
+    rofi_int_matcher *rm    = g_malloc0 ( sizeof ( rofi_int_matcher ) );
+    rm->type           = ROFI_MATCHER_GLOB;
+    rm->case_sensitive = case_sensitive;
+    rm->leading_star   = ( len > 0 && chars[0] == '*' );
+    rm->trailing_star  = ( len > 0 && chars[len - 1] == '*' );
+    for ( glong i = 0; i < len; ) {
+        if ( chars[i] == '*' ) {
+            i++;
+            continue;
+        }
+        glong start = i;
+        while ( i < len && chars[i] != '*' ) {
+            i++;
+        }
+        if ( ( i - start ) > ROFI_GLOB_SEGMENT_MAX_LENGTH ) {
+            rofi_int_matcher_free ( rm );
+            g_free ( chars );
+            return NULL;
+        }
+        rm->segments = g_realloc ( rm->segments, ( rm->num_segments + 1 ) * sizeof ( rofi_int_glob_segment ) );
+        rofi_int_glob_segment *seg = &( rm->segments[rm->num_segments++] );
+        memset ( seg, 0, sizeof ( rofi_int_glob_segment ) );
+        seg->length = i - start;
+        for ( unsigned int j = 0; j < seg->length; j++ ) {
+            gunichar c   = chars[start + j];
+            guint64  bit = G_GUINT64_CONSTANT ( 1 ) << j;
+            if ( c == '?' ) {
+                for ( unsigned int k = 0; k < 128; k++ ) {
+                    if ( !g_ascii_isspace ( k ) ) {
+                        seg->ascii_mask[k] |= bit;
+                    }
+                }
+                seg->any_mask |= bit;
+            }
+            else if ( c < 0x80 ) {
+                rm->signature      |= helper_signature_bit ( c );
+                seg->ascii_mask[c] |= bit;
+                if ( !case_sensitive ) {
+                    seg->ascii_mask[(unsigned char) g_ascii_tolower ( c )] |= bit;
+                    seg->ascii_mask[(unsigned char) g_ascii_toupper ( c )] |= bit;
+                }
+            }
+            else {
+                if ( seg->uchars == NULL ) {
+                    seg->uchars = g_malloc0_n ( seg->length, sizeof ( gunichar ) );
+                }
+                seg->uchars[j] = case_sensitive ? c : g_unichar_tolower ( c );
+                rm->signature |= helper_signature_bit ( c );
             }
         }
-        g_string_append_unichar ( str, g_utf8_get_char ( iter ) );
-        g_string_append ( str, ")" );
-        first = 0;
     }
-    g_free ( r );
-    char *retv = str->str;
-    g_string_free ( str, FALSE );
-    return retv;
+    g_free ( chars );
+    return rm;
 }
 
-// Macro for quickly generating regex for matching.
-static inline GRegex * R ( const char *s, int case_sensitive  )
+/**
+ * @param regex The compiled regex.
+ * @param case_sensitive Whether case is significant.
+ *
+ * @returns a newly allocated regex matcher wrapping regex, or NULL if regex is NULL.
+ */
+static rofi_int_matcher * create_regex_matcher ( GRegex *regex, int case_sensitive )
 {
-    return g_regex_new ( s, G_REGEX_OPTIMIZE | ( ( case_sensitive ) ? 0 : G_REGEX_CASELESS ), 0, NULL );
+    if ( regex == NULL ) {
+        return NULL;
+    }
+    rofi_int_matcher *rm = g_malloc0 ( sizeof ( rofi_int_matcher ) );
+    rm->type           = ROFI_MATCHER_REGEX;
+    rm->case_sensitive = case_sensitive;
+    rm->regex          = regex;
+    return rm;
 }
 
-static GRegex * create_regex ( const char *input, int case_sensitive )
+static rofi_int_matcher * create_regex ( const char *input, int case_sensitive )
 {
-    GRegex * retv = NULL;
-    gchar  *r;
+    rofi_int_matcher * retv = NULL;
+    gchar            *r;
     switch ( config.matching_method )
     {
     case MM_GLOB:
-        r    = glob_to_regex ( input );
-        retv = R ( r, case_sensitive );
-        g_free ( r );
+        retv = create_glob_matcher ( input, case_sensitive );
+        if ( retv == NULL ) {
+            // Too long for the automaton, fall back to regex.
+            r    = glob_to_regex ( input );
+            retv = create_regex_matcher ( R ( r, case_sensitive ), case_sensitive );
+            g_free ( r );
+        }
         break;
     case MM_REGEX:
-        retv = R ( input, case_sensitive );
+        retv = create_regex_matcher ( R ( input, case_sensitive ), case_sensitive );
         if ( retv == NULL ) {
-            r    = g_regex_escape_string ( input, -1 );
-            retv = R ( r, case_sensitive );
-            g_free ( r );
+            // Invalid regex, match it as plain text.
+            retv = create_needle_matcher ( ROFI_MATCHER_LITERAL, input, case_sensitive );
         }
         break;
     case MM_FUZZY:
-        r    = fuzzy_to_regex ( input );
-        retv = R ( r, case_sensitive );
-        g_free ( r );
+        retv = create_needle_matcher ( ROFI_MATCHER_FUZZY, input, case_sensitive );
         break;
     default:
-        r    = g_regex_escape_string ( input, -1 );
-        retv = R ( r, case_sensitive );
-        g_free ( r );
+        retv = create_needle_matcher ( ROFI_MATCHER_LITERAL, input, case_sensitive );
         break;
     }
     return retv;
 }
-GRegex **tokenize ( const char *input, int case_sensitive )
+/**
+ * @param rm The token.
+ *
+ * Literal tokens that match byte for byte can be found by the #RofiLiteralSet.
+ *
+ * @returns TRUE when rm can be added to a #RofiLiteralSet.
+ */
+static gboolean tokenize_literal_set_eligible ( const rofi_int_matcher *rm )
+{
+    return rm->type == ROFI_MATCHER_LITERAL && rm->needle_len > 0 && ( rm->case_sensitive || rm->ascii );
+}
+
+/**
+ * @param tokens The NULL terminated token array.
+ *
+ * Build the automaton finding the literal tokens and attach it to the first token.
+ * Nothing is built when there are fewer than two literal tokens, a single needle is
+ * found faster with helper_literal_find().
+ */
+static void tokenize_literal_set ( rofi_int_matcher **tokens )
+{
+    unsigned int num_literals = 0;
+    size_t       num_bytes    = 0;
+    for ( unsigned int i = 0; tokens[i] != NULL && num_literals < LITERAL_SET_MAX_TOKENS; i++ ) {
+        if ( tokenize_literal_set_eligible ( tokens[i] ) ) {
+            num_literals++;
+            num_bytes += tokens[i]->needle_len;
+        }
+    }
+    if ( num_literals < 2 ) {
+        return;
+    }
+
+    RofiLiteralSet *set = g_malloc0 ( sizeof ( RofiLiteralSet ) );
+    set->tokens      = tokens;
+    set->num_classes = 1;
+    for ( unsigned int i = 0, n = 0; tokens[i] != NULL && n < num_literals; i++ ) {
+        if ( !tokenize_literal_set_eligible ( tokens[i] ) ) {
+            continue;
+        }
+        n++;
+        for ( size_t k = 0; k < tokens[i]->needle_len; k++ ) {
+            guchar b = (guchar) tokens[i]->needle[k];
+            if ( set->classes[b] == 0 ) {
+                set->classes[b] = set->num_classes++;
+                if ( !tokens[i]->case_sensitive ) {
+                    // Needle is lower-cased, the upper-case letter goes to the same class.
+                    set->classes[(guchar) g_ascii_toupper ( b )] = set->classes[b];
+                }
+            }
+        }
+    }
+
+    // Trie of the needles, a 0 transition means there is no edge.
+    const unsigned int nc         = set->num_classes;
+    unsigned int       num_states = 1;
+    set->delta = g_malloc0 ( sizeof ( unsigned int ) * nc * ( num_bytes + 1 ) );
+    set->out   = g_malloc0 ( sizeof ( guint64 ) * ( num_bytes + 1 ) );
+    for ( unsigned int i = 0, n = 0; tokens[i] != NULL && n < num_literals; i++ ) {
+        if ( !tokenize_literal_set_eligible ( tokens[i] ) ) {
+            continue;
+        }
+        unsigned int state = 0;
+        for ( size_t k = 0; k < tokens[i]->needle_len; k++ ) {
+            unsigned int *t = &( set->delta[state * nc + set->classes[(guchar) tokens[i]->needle[k]]] );
+            if ( *t == 0 ) {
+                *t = num_states++;
+            }
+            state = *t;
+        }
+        tokens[i]->literal_mask = G_GUINT64_CONSTANT ( 1 ) << n;
+        set->out[state]        |= tokens[i]->literal_mask;
+        set->all               |= tokens[i]->literal_mask;
+        n++;
+    }
+
+    // Breadth first, fill in the missing transitions from the state of the failure link.
+    // Missing transitions of the root go back to the root.
+    unsigned int *fail  = g_malloc0 ( sizeof ( unsigned int ) * num_states );
+    unsigned int *queue = g_malloc ( sizeof ( unsigned int ) * num_states );
+    unsigned int head   = 0, tail = 0;
+    for ( unsigned int c = 0; c < nc; c++ ) {
+        if ( set->delta[c] != 0 ) {
+            queue[tail++] = set->delta[c];
+        }
+    }
+    while ( head < tail ) {
+        unsigned int state = queue[head++];
+        set->out[state] |= set->out[fail[state]];
+        for ( unsigned int c = 0; c < nc; c++ ) {
+            unsigned int *t = &( set->delta[state * nc + c] );
+            if ( *t != 0 ) {
+                fail[*t]      = set->delta[fail[state] * nc + c];
+                queue[tail++] = *t;
+            }
+            else {
+                *t = set->delta[fail[state] * nc + c];
+            }
+        }
+    }
+    g_free ( queue );
+    g_free ( fail );
+    tokens[0]->literals = set;
+}
+
+rofi_int_matcher **tokenize ( const char *input, int case_sensitive )
 {
     if ( input == NULL ) {
         return NULL;
@@ -255,11 +573,11 @@ GRegex **tokenize ( const char *input, int case_sensitive )
         return NULL;
     }
 
-    char   *saveptr = NULL, *token;
-    GRegex **retv = NULL;
+    char             *saveptr = NULL, *token;
+    rofi_int_matcher **retv   = NULL;
     if ( !config.tokenize ) {
-        retv    = g_malloc0 ( sizeof ( GRegex* ) * 2 );
-        retv[0] = (GRegex *) create_regex ( input, case_sensitive );
+        retv    = g_malloc0 ( sizeof ( rofi_int_matcher* ) * 2 );
+        retv[0] = create_regex ( input, case_sensitive );
         return retv;
     }
 
@@ -273,13 +591,16 @@ GRegex **tokenize ( const char *input, int case_sensitive )
     // strtok should still be valid for utf8.
     const char * const sep = " ";
     for ( token = strtok_r ( str, sep, &saveptr ); token != NULL; token = strtok_r ( NULL, sep, &saveptr ) ) {
-        retv                 = g_realloc ( retv, sizeof ( GRegex* ) * ( num_tokens + 2 ) );
-        retv[num_tokens]     = (GRegex *) create_regex ( token, case_sensitive );
+        retv                 = g_realloc ( retv, sizeof ( rofi_int_matcher* ) * ( num_tokens + 2 ) );
+        retv[num_tokens]     = create_regex ( token, case_sensitive );
         retv[num_tokens + 1] = NULL;
         num_tokens++;
     }
     // Free str.
     g_free ( str );
+    if ( num_tokens > 1 ) {
+        tokenize_literal_set ( retv );
+    }
     return retv;
 }
 
@@ -399,66 +720,671 @@ int find_arg_char ( const char * const key, char *val )
     return FALSE;
 }
 
-PangoAttrList *helper_token_match_get_pango_attr ( ThemeHighlight th, GRegex **tokens, const char *input, PangoAttrList *retv )
+/**
+ * @param haystack The string to search in.
+ * @param needle   The lower-cased ASCII needle.
+ * @param needle_len The length of needle.
+ *
+ * ASCII case insensitive substring search.
+ * strchr/strpbrk are vectorized in the common libc implementations, so use them to skip
+ * to the candidate positions and only compare the remainder there.
+ * Non ASCII bytes in haystack never match, as needle only holds ASCII characters.
+ *
+ * @returns pointer to the first match in haystack, or NULL if not found.
+ */
+static const char *helper_ascii_casestr ( const char *haystack, const char *needle, size_t needle_len )
+{
+    const char first[3] = { needle[0], g_ascii_toupper ( needle[0] ), '\0' };
+    const char *p       = ( first[0] == first[1] ) ? strchr ( haystack, first[0] ) : strpbrk ( haystack, first );
+    while ( p != NULL ) {
+        size_t i = 1;
+        while ( i < needle_len && g_ascii_tolower ( p[i] ) == needle[i] ) {
+            i++;
+        }
+        if ( i == needle_len ) {
+            return p;
+        }
+        p = ( first[0] == first[1] ) ? strchr ( p + 1, first[0] ) : strpbrk ( p + 1, first );
+    }
+    return NULL;
+}
+
+/**
+ * @param haystack The (valid UTF-8) string to search in.
+ * @param needle   The decoded, lower-cased, needle.
+ * @param needle_len The length of needle in characters.
+ * @param end      Set to the end of the match. [out]
+ *
+ * UTF-8 aware case insensitive substring search, used when the needle is not pure ASCII.
+ *
+ * @returns pointer to the first match in haystack, or NULL if not found.
+ */
+static const char *helper_utf8_casestr ( const char *haystack, const gunichar *needle, glong needle_len, const char **end )
+{
+    for ( const char *p = haystack; *p != '\0'; p = g_utf8_next_char ( p ) ) {
+        const char *iter = p;
+        glong      i     = 0;
+        while ( i < needle_len && *iter != '\0' && g_unichar_tolower ( g_utf8_get_char ( iter ) ) == needle[i] ) {
+            iter = g_utf8_next_char ( iter );
+            i++;
+        }
+        if ( i == needle_len ) {
+            *end = iter;
+            return p;
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @param rm    The literal matcher.
+ * @param input The string to search in.
+ * @param end   Set to the end of the match. [out]
+ *
+ * Find the first occurrence of the needle of rm in input.
+ *
+ * @returns pointer to the start of the match, or NULL if not found.
+ */
+static const char *helper_literal_find ( const rofi_int_matcher *rm, const char *input, const char **end )
+{
+    const char *p = NULL;
+    if ( rm->case_sensitive ) {
+        p = strstr ( input, rm->needle );
+    }
+    else if ( rm->ascii ) {
+        p = helper_ascii_casestr ( input, rm->needle, rm->needle_len );
+    }
+    else {
+        return helper_utf8_casestr ( input, rm->uneedle, rm->uneedle_len, end );
+    }
+    if ( p != NULL ) {
+        *end = p + rm->needle_len;
+    }
+    return p;
+}
+
+/**
+ * @param rm    The fuzzy matcher.
+ * @param input The string to search in.
+ * @param end   Set to the end of the match. [out]
+ *
+ * Find the characters of the needle, in order, in input. Characters are matched greedy from the left,
+ * so this runs in linear time without any backtracking.
+ * Like the '(a).*(b)' regex this replaces, a match cannot span a newline.
+ *
+ * @returns pointer to the leftmost possible start of the match, or NULL if not found.
+ */
+static const char *helper_fuzzy_find ( const rofi_int_matcher *rm, const char *input, const char **end )
+{
+    const char *start = NULL;
+    if ( rm->ascii ) {
+        const char *p = input;
+        size_t     i  = 0;
+        while ( i < rm->needle_len ) {
+            p = strpbrk ( p, &( rm->accept[i * 4] ) );
+            if ( p == NULL ) {
+                return NULL;
+            }
+            if ( *p == '\n' && rm->needle[i] != '\n' ) {
+                // Restart on the next line.
+                i = 0;
+            }
+            else {
+                if ( i == 0 ) {
+                    start = p;
+                }
+                i++;
+            }
+            p++;
+        }
+        *end = p;
+        return start;
+    }
+    glong      i = 0;
+    const char *p;
+    for ( p = input; *p != '\0' && i < rm->uneedle_len; p = g_utf8_next_char ( p ) ) {
+        gunichar c = g_utf8_get_char ( p );
+        if ( c == '\n' && rm->uneedle[i] != '\n' ) {
+            // Restart on the next line.
+            i = 0;
+            continue;
+        }
+        if ( !rm->case_sensitive ) {
+            c = g_unichar_tolower ( c );
+        }
+        if ( c == rm->uneedle[i] ) {
+            if ( i == 0 ) {
+                start = p;
+            }
+            i++;
+        }
+    }
+    if ( i < rm->uneedle_len ) {
+        return NULL;
+    }
+    *end = p;
+    return start;
+}
+
+/**
+ * @param seg      The glob segment.
+ * @param case_sensitive Whether case is significant.
+ * @param p        Where to start searching.
+ * @param line_end Where to stop searching.
+ * @param end      Set to the end of the match. [out]
+ *
+ * Run the shift-and automaton of seg over p till line_end.
+ *
+ * @returns pointer to the start of the first match, or NULL if not found.
+ */
+static const char *helper_glob_segment_find ( const rofi_int_glob_segment *seg, gboolean case_sensitive, const char *p, const char *line_end, const char **end )
+{
+    // Start of the last characters, so we can find the start of the match.
+    const char    *pos[ROFI_GLOB_SEGMENT_MAX_LENGTH];
+    const guint64 hit = G_GUINT64_CONSTANT ( 1 ) << ( seg->length - 1 );
+    guint64       d   = 0;
+    unsigned int  n   = 0;
+    while ( p < line_end ) {
+        guint64       mask;
+        const char    *next;
+        unsigned char b = *p;
+        if ( b < 0x80 ) {
+            mask = seg->ascii_mask[b];
+            next = p + 1;
+        }
+        else {
+            mask = seg->any_mask;
+            if ( seg->uchars != NULL ) {
+                gunichar c = g_utf8_get_char ( p );
+                if ( !case_sensitive ) {
+                    c = g_unichar_tolower ( c );
+                }
+                for ( unsigned int j = 0; j < seg->length; j++ ) {
+                    if ( seg->uchars[j] == c ) {
+                        mask |= G_GUINT64_CONSTANT ( 1 ) << j;
+                    }
+                }
+            }
+            next = g_utf8_next_char ( p );
+        }
+        pos[n % ROFI_GLOB_SEGMENT_MAX_LENGTH] = p;
+        n++;
+        d = ( ( d << 1 ) | 1 ) & mask;
+        if ( d & hit ) {
+            *end = next;
+            return pos[( n - seg->length ) % ROFI_GLOB_SEGMENT_MAX_LENGTH];
+        }
+        p = next;
+    }
+    return NULL;
+}
+
+/**
+ * @param rm    The glob matcher.
+ * @param input The string to search in.
+ * @param end   Set to the end of the match, can be NULL. [out]
+ *
+ * Find the glob in input. The segments are matched from the left, one after the other, on the same line.
+ * When end is requested, it is set where the (greedy) '*' would stop.
+ *
+ * @returns pointer to the start of the match, or NULL if not found.
+ */
+static const char *helper_glob_find ( const rofi_int_matcher *rm, const char *input, const char **end )
 {
+    const char *line = input;
+    while ( TRUE ) {
+        const char *line_end = strchr ( line, '\n' );
+        if ( line_end == NULL ) {
+            line_end = line + strlen ( line );
+        }
+        const char   *start = line, *seg_start = NULL, *p = line;
+        unsigned int i;
+        for ( i = 0; i < rm->num_segments; i++ ) {
+            seg_start = helper_glob_segment_find ( &( rm->segments[i] ), rm->case_sensitive, p, line_end, &p );
+            if ( seg_start == NULL ) {
+                break;
+            }
+            if ( i == 0 && !rm->leading_star ) {
+                start = seg_start;
+            }
+        }
+        if ( i == rm->num_segments ) {
+            if ( end == NULL ) {
+                return start;
+            }
+            if ( rm->trailing_star || rm->num_segments == 0 ) {
+                *end = line_end;
+            }
+            else if ( rm->num_segments > 1 || rm->leading_star ) {
+                // The '*' is greedy, find the last occurrence of the last segment.
+                const rofi_int_glob_segment *last     = &( rm->segments[rm->num_segments - 1] );
+                const char                  *next_end = NULL;
+                for ( const char *s = helper_glob_segment_find ( last, rm->case_sensitive, g_utf8_next_char ( seg_start ), line_end, &next_end );
+                      s != NULL;
+                      s = helper_glob_segment_find ( last, rm->case_sensitive, g_utf8_next_char ( s ), line_end, &next_end ) ) {
+                    p = next_end;
+                }
+                *end = p;
+            }
+            else {
+                *end = p;
+            }
+            return start;
+        }
+        if ( *line_end == '\0' ) {
+            return NULL;
+        }
+        line = line_end + 1;
+    }
+}
+
+/**
+ * @param th    The ThemeHighlight
+ * @param start Start (in bytes) of the range to highlight.
+ * @param end   End (in bytes) of the range to highlight.
+ * @param retv  The Attribute list to update.
+ *
+ * Add the highlight attributes for the range start-end to retv.
+ */
+static void helper_token_match_set_pango_attr_range ( ThemeHighlight th, int start, int end, PangoAttrList *retv )
+{
+    if ( th.style & HL_BOLD ) {
+        PangoAttribute *pa = pango_attr_weight_new ( PANGO_WEIGHT_BOLD );
+        pa->start_index = start;
+        pa->end_index   = end;
+        pango_attr_list_insert ( retv, pa );
+    }
+    if ( th.style & HL_UNDERLINE ) {
+        PangoAttribute *pa = pango_attr_underline_new ( PANGO_UNDERLINE_SINGLE );
+        pa->start_index = start;
+        pa->end_index   = end;
+        pango_attr_list_insert ( retv, pa );
+    }
+    if ( th.style & HL_ITALIC ) {
+        PangoAttribute *pa = pango_attr_style_new ( PANGO_STYLE_ITALIC );
+        pa->start_index = start;
+        pa->end_index   = end;
+        pango_attr_list_insert ( retv, pa );
+    }
+    if ( th.style & HL_COLOR ) {
+        PangoAttribute *pa = pango_attr_foreground_new (
+            th.color.red * 65535,
+            th.color.green * 65535,
+            th.color.blue * 65535 );
+        pa->start_index = start;
+        pa->end_index   = end;
+        pango_attr_list_insert ( retv, pa );
+    }
+}
+
+/**
+ * @param ranges The ranges to append to.
+ * @param start  Start (in bytes) of the matched range.
+ * @param end    End (in bytes) of the matched range.
+ */
+static void helper_token_match_add_range ( GArray *ranges, int start, int end )
+{
+    rofi_range_pair range = { start, end };
+    g_array_append_val ( ranges, range );
+}
+
+/**
+ * @param rm     The fuzzy matcher.
+ * @param input  The string to find the matches on.
+ * @param ranges The ranges to append to.
+ *
+ * Find the characters matched by a fuzzy matcher, for every match. This picks the same characters as the
+ * (greedy) regex did: the first one at its leftmost position, the others as late as possible on that line.
+ */
+static void helper_fuzzy_get_ranges ( const rofi_int_matcher *rm, const char *input, GArray *ranges )
+{
+    const char *iter = input;
+    const char *end  = NULL;
+    const char *start;
+    // Like the '(a).*(b)' regex, every match is highlighted, the next match starts behind the previous.
+    while ( *iter != '\0' && ( start = helper_fuzzy_find ( rm, iter, &end ) ) != NULL ) {
+        helper_token_match_add_range ( ranges, start - input, g_utf8_next_char ( start ) - input );
+        iter = g_utf8_next_char ( start );
+        const char *p = strchr ( end, '\n' );
+        if ( p == NULL ) {
+            p = end + strlen ( end );
+        }
+        for ( glong i = rm->uneedle_len - 1; i > 0; i-- ) {
+            gunichar c;
+            do {
+                p = g_utf8_prev_char ( p );
+                c = g_utf8_get_char ( p );
+                if ( !rm->case_sensitive ) {
+                    c = g_unichar_tolower ( c );
+                }
+            } while ( c != rm->uneedle[i] );
+            helper_token_match_add_range ( ranges, p - input, g_utf8_next_char ( p ) - input );
+            if ( i == ( rm->uneedle_len - 1 ) ) {
+                // The greedy '.*' puts the end of the match behind the last occurrence on the line.
+                iter = g_utf8_next_char ( p );
+            }
+        }
+    }
+}
+
+GArray *helper_token_match_get_ranges ( rofi_int_matcher **tokens, const char *input )
+{
+    GArray *ranges = g_array_new ( FALSE, FALSE, sizeof ( rofi_range_pair ) );
     // Do a tokenized match.
     if ( tokens ) {
         for ( int j = 0; tokens[j]; j++ ) {
+            if ( tokens[j]->type == ROFI_MATCHER_LITERAL ) {
+                const char *end = NULL;
+                for ( const char *p = helper_literal_find ( tokens[j], input, &end );
+                      p != NULL;
+                      p = helper_literal_find ( tokens[j], end, &end ) ) {
+                    helper_token_match_add_range ( ranges, p - input, end - input );
+                }
+                continue;
+            }
+            if ( tokens[j]->type == ROFI_MATCHER_FUZZY ) {
+                helper_fuzzy_get_ranges ( tokens[j], input, ranges );
+                continue;
+            }
+            if ( tokens[j]->type == ROFI_MATCHER_GLOB ) {
+                const char *iter = input, *end = NULL, *p;
+                while ( ( p = helper_glob_find ( tokens[j], iter, &end ) ) != NULL ) {
+                    if ( end > p ) {
+                        helper_token_match_add_range ( ranges, p - input, end - input );
+                        iter = end;
+                    }
+                    else if ( *end != '\0' ) {
+                        // Empty match, skip a character.
+                        iter = g_utf8_next_char ( end );
+                    }
+                    else {
+                        break;
+                    }
+                }
+                continue;
+            }
             GMatchInfo *gmi = NULL;
-            g_regex_match ( (GRegex *) tokens[j], input, G_REGEX_MATCH_PARTIAL, &gmi );
+            g_regex_match ( tokens[j]->regex, input, G_REGEX_MATCH_PARTIAL, &gmi );
             while ( g_match_info_matches ( gmi ) ) {
                 int count = g_match_info_get_match_count ( gmi );
                 for ( int index = ( count > 1 ) ? 1 : 0; index < count; index++ ) {
                     int start, end;
                     g_match_info_fetch_pos ( gmi, index, &start, &end );
-                    if ( th.style & HL_BOLD ) {
-                        PangoAttribute *pa = pango_attr_weight_new ( PANGO_WEIGHT_BOLD );
-                        pa->start_index = start;
-                        pa->end_index   = end;
-                        pango_attr_list_insert ( retv, pa );
-                    }
-                    if ( th.style & HL_UNDERLINE ) {
-                        PangoAttribute *pa = pango_attr_underline_new ( PANGO_UNDERLINE_SINGLE );
-                        pa->start_index = start;
-                        pa->end_index   = end;
-                        pango_attr_list_insert ( retv, pa );
-                    }
-                    if ( th.style & HL_ITALIC ) {
-                        PangoAttribute *pa = pango_attr_style_new ( PANGO_STYLE_ITALIC );
-                        pa->start_index = start;
-                        pa->end_index   = end;
-                        pango_attr_list_insert ( retv, pa );
-                    }
-                    if ( th.style & HL_COLOR ) {
-                        PangoAttribute *pa = pango_attr_foreground_new (
-                            th.color.red * 65535,
-                            th.color.green * 65535,
-                            th.color.blue * 65535 );
-                        pa->start_index = start;
-                        pa->end_index   = end;
-                        pango_attr_list_insert ( retv, pa );
-                    }
+                    helper_token_match_add_range ( ranges, start, end );
                 }
                 g_match_info_next ( gmi, NULL );
             }
             g_match_info_free ( gmi );
         }
     }
+    return ranges;
+}
+
+PangoAttrList *helper_token_match_ranges_get_pango_attr ( ThemeHighlight th, const GArray *ranges, PangoAttrList *retv )
+{
+    for ( guint i = 0; i < ranges->len; i++ ) {
+        const rofi_range_pair *range = &g_array_index ( ranges, rofi_range_pair, i );
+        helper_token_match_set_pango_attr_range ( th, range->start, range->end, retv );
+    }
     return retv;
 }
 
-int helper_token_match ( GRegex * const *tokens, const char *input )
+PangoAttrList *helper_token_match_get_pango_attr ( ThemeHighlight th, rofi_int_matcher **tokens, const char *input, PangoAttrList *retv )
+{
+    GArray *ranges = helper_token_match_get_ranges ( tokens, input );
+    helper_token_match_ranges_get_pango_attr ( th, ranges, retv );
+    g_array_free ( ranges, TRUE );
+    return retv;
+}
+
+/**
+ * @param rm    The matcher.
+ * @param input The entry to match against.
+ *
+ * Match a single token against input.
+ *
+ * @returns TRUE when matches, FALSE otherwise
+ */
+static gboolean helper_matcher_match ( const rofi_int_matcher *rm, const char *input )
+{
+    switch ( rm->type )
+    {
+    case ROFI_MATCHER_LITERAL:
+    {
+        const char *end = NULL;
+        return helper_literal_find ( rm, input, &end ) != NULL;
+    }
+    case ROFI_MATCHER_FUZZY:
+    {
+        const char *end = NULL;
+        return helper_fuzzy_find ( rm, input, &end ) != NULL;
+    }
+    case ROFI_MATCHER_GLOB:
+        return helper_glob_find ( rm, input, NULL ) != NULL;
+    case ROFI_MATCHER_REGEX:
+    default:
+        return g_regex_match ( rm->regex, input, 0, NULL );
+    }
+}
+
+/**
+ * @param tokens List of (input) tokens.
+ *
+ * The automaton is only valid for the array it was built for, not for a sub-set of the tokens.
+ *
+ * @returns the #RofiLiteralSet of tokens, or NULL if none.
+ */
+static inline const RofiLiteralSet *helper_token_literal_set ( rofi_int_matcher * const *tokens )
+{
+    if ( tokens[0] != NULL && tokens[0]->literals != NULL && tokens[0]->literals->tokens == tokens ) {
+        return tokens[0]->literals;
+    }
+    return NULL;
+}
+
+/**
+ * @param set   The automaton.
+ * @param input The entry to search in.
+ * @param found The bits of the tokens already found.
+ *
+ * Find the literal tokens in input, stops as soon as all are found.
+ *
+ * @returns found with the bits of the tokens found in input added.
+ */
+static guint64 helper_literal_set_scan ( const RofiLiteralSet *set, const char *input, guint64 found )
+{
+    unsigned int state = 0;
+    for ( const guchar *p = (const guchar *) input; *p != '\0' && found != set->all; p++ ) {
+        state  = set->delta[state * set->num_classes + set->classes[*p]];
+        found |= set->out[state];
+    }
+    return found;
+}
+
+int helper_token_match ( rofi_int_matcher * const *tokens, const char *input )
 {
     int match = TRUE;
     // Do a tokenized match.
     if ( tokens ) {
+        const RofiLiteralSet *set = helper_token_literal_set ( tokens );
+        if ( set != NULL && helper_literal_set_scan ( set, input, 0 ) != set->all ) {
+            return FALSE;
+        }
         for ( int j = 0; match && tokens[j]; j++ ) {
-            match = g_regex_match ( (const GRegex *) tokens[j], input, 0, NULL );
+            if ( set == NULL || tokens[j]->literal_mask == 0 ) {
+                match = helper_matcher_match ( tokens[j], input );
+            }
         }
     }
     return match;
 }
 
+int helper_token_match_fields ( rofi_int_matcher * const *tokens, const char * const *fields, unsigned int num_fields )
+{
+    if ( tokens == NULL ) {
+        return TRUE;
+    }
+    const RofiLiteralSet *set = helper_token_literal_set ( tokens );
+    if ( set != NULL ) {
+        guint64 found = 0;
+        for ( unsigned int i = 0; i < num_fields && found != set->all; i++ ) {
+            if ( fields[i] != NULL ) {
+                found = helper_literal_set_scan ( set, fields[i], found );
+            }
+        }
+        if ( found != set->all ) {
+            return FALSE;
+        }
+    }
+    for ( int j = 0; tokens[j]; j++ ) {
+        if ( set != NULL && tokens[j]->literal_mask != 0 ) {
+            continue;
+        }
+        int match = FALSE;
+        for ( unsigned int i = 0; !match && i < num_fields; i++ ) {
+            if ( fields[i] != NULL ) {
+                match = helper_matcher_match ( tokens[j], fields[i] );
+            }
+        }
+        if ( !match ) {
+            return FALSE;
+        }
+    }
+    return TRUE;
+}
+
+/**
+ * Trigram index, maps each (ASCII lower-cased) trigram to the sorted list of lines containing it.
+ */
+struct _RofiTrigramIndex
+{
+    /** Trigram key -> GArray with line indexes. */
+    GHashTable *postings;
+};
+
+/**
+ * @param s Pointer to three characters.
+ *
+ * @returns TRUE when the three characters are non-zero ASCII.
+ */
+static inline gboolean helper_trigram_valid ( const char *s )
+{
+    return s[0] != '\0' && s[1] != '\0' && s[2] != '\0' && ( ( s[0] | s[1] | s[2] ) & 0x80 ) == 0;
+}
+
+/**
+ * @param s Pointer to three ASCII characters.
+ *
+ * @returns the (case folded) key of the trigram.
+ */
+static inline guint helper_trigram_key ( const char *s )
+{
+    return ( g_ascii_tolower ( s[0] ) << 14 ) | ( g_ascii_tolower ( s[1] ) << 7 ) | g_ascii_tolower ( s[2] );
+}
+
+static void helper_trigram_posting_free ( gpointer data )
+{
+    g_array_free ( (GArray *) data, TRUE );
+}
+
+RofiTrigramIndex *helper_trigram_index_new ( char * const *lines, unsigned int length, volatile gint *cancel )
+{
+    RofiTrigramIndex *index = g_malloc0 ( sizeof ( RofiTrigramIndex ) );
+    index->postings = g_hash_table_new_full ( g_direct_hash, g_direct_equal, NULL, helper_trigram_posting_free );
+    for ( unsigned int i = 0; i < length; i++ ) {
+        if ( cancel != NULL && ( i % 1024 ) == 0 && g_atomic_int_get ( cancel ) ) {
+            helper_trigram_index_free ( index );
+            return NULL;
+        }
+        for ( const char *iter = lines[i]; iter[0] != '\0'; iter++ ) {
+            if ( !helper_trigram_valid ( iter ) ) {
+                continue;
+            }
+            gpointer key   = GUINT_TO_POINTER ( helper_trigram_key ( iter ) );
+            GArray   *list = g_hash_table_lookup ( index->postings, key );
+            if ( list == NULL ) {
+                list = g_array_new ( FALSE, FALSE, sizeof ( unsigned int ) );
+                g_hash_table_insert ( index->postings, key, list );
+            }
+            // Lines are added in order, only need to check the last one for duplicates.
+            if ( list->len == 0 || g_array_index ( list, unsigned int, list->len - 1 ) != i ) {
+                g_array_append_val ( list, i );
+            }
+        }
+    }
+    return index;
+}
+
+void helper_trigram_index_free ( RofiTrigramIndex *index )
+{
+    if ( index == NULL ) {
+        return;
+    }
+    g_hash_table_destroy ( index->postings );
+    g_free ( index );
+}
+
+static gint helper_trigram_posting_cmp ( gconstpointer a, gconstpointer b )
+{
+    const GArray *la = *( (GArray * const *) a );
+    const GArray *lb = *( (GArray * const *) b );
+    return ( la->len > lb->len ) - ( la->len < lb->len );
+}
+
+unsigned int *helper_trigram_index_query ( const RofiTrigramIndex *index, rofi_int_matcher * const *tokens, unsigned int *length )
+{
+    GPtrArray *lists = g_ptr_array_new ();
+    for ( int j = 0; tokens != NULL && tokens[j] != NULL; j++ ) {
+        const rofi_int_matcher *rm = tokens[j];
+        // The UTF-8 path folds non ASCII characters to ASCII ones, only the byte compares are safe.
+        if ( rm->type != ROFI_MATCHER_LITERAL || !( rm->ascii || rm->case_sensitive ) ) {
+            continue;
+        }
+        for ( const char *iter = rm->needle; iter[0] != '\0'; iter++ ) {
+            if ( !helper_trigram_valid ( iter ) ) {
+                continue;
+            }
+            GArray *list = g_hash_table_lookup ( index->postings, GUINT_TO_POINTER ( helper_trigram_key ( iter ) ) );
+            if ( list == NULL ) {
+                // Nothing can match.
+                g_ptr_array_free ( lists, TRUE );
+                *length = 0;
+                return g_malloc0 ( sizeof ( unsigned int ) );
+            }
+            g_ptr_array_add ( lists, list );
+        }
+    }
+    if ( lists->len == 0 ) {
+        g_ptr_array_free ( lists, TRUE );
+        return NULL;
+    }
+    // Start with the shortest list, it bounds the result.
+    g_ptr_array_sort ( lists, helper_trigram_posting_cmp );
+    GArray       *first = g_ptr_array_index ( lists, 0 );
+    unsigned int *retv  = g_memdup ( first->data, MAX ( 1, first->len ) * sizeof ( unsigned int ) );
+    unsigned int n      = first->len;
+    for ( unsigned int l = 1; l < lists->len && n > 0; l++ ) {
+        GArray             *list = g_ptr_array_index ( lists, l );
+        const unsigned int *data = (const unsigned int *) list->data;
+        unsigned int       k     = 0, m = 0;
+        for ( unsigned int i = 0; i < n; i++ ) {
+            while ( k < list->len && data[k] < retv[i] ) {
+                k++;
+            }
+            if ( k == list->len ) {
+                break;
+            }
+            if ( data[k] == retv[i] ) {
+                retv[m++] = retv[i];
+            }
+        }
+        n = m;
+    }
+    g_ptr_array_free ( lists, TRUE );
+    *length = n;
+    return retv;
+}
+
 int execute_generator ( const char * cmd )
 {
     char **args = NULL;
@@ -674,39 +1600,217 @@ char *rofi_expand_path ( const char *input )
     return retv;
 }
 
-/** Return the minimum value of a,b,c */
-#define MIN3( a, b, c )    ( ( a ) < ( b ) ? ( ( a ) < ( c ) ? ( a ) : ( c ) ) : ( ( b ) < ( c ) ? ( b ) : ( c ) ) )
+void helper_corpus_entry_init ( rofi_int_corpus_entry *entry, const char *str, int case_sensitive )
+{
+    entry->chars  = g_utf8_to_ucs4_fast ( str, -1, &( entry->length ) );
+    entry->folded = NULL;
+    if ( case_sensitive ) {
+        return;
+    }
+    for ( glong i = 0; i < entry->length; i++ ) {
+        gunichar c = g_unichar_tolower ( entry->chars[i] );
+        if ( c != entry->chars[i] ) {
+            if ( entry->folded == NULL ) {
+                // Only store the folded form when it differs.
+                entry->folded = g_memdup ( entry->chars, ( entry->length + 1 ) * sizeof ( gunichar ) );
+            }
+            entry->folded[i] = c;
+        }
+    }
+}
 
-unsigned int levenshtein ( const char *needle, const glong needlelen, const char *haystack, const glong haystacklen )
+void helper_corpus_entry_clear ( rofi_int_corpus_entry *entry )
+{
+    g_free ( entry->chars );
+    g_free ( entry->folded );
+    entry->chars  = NULL;
+    entry->folded = NULL;
+    entry->length = 0;
+}
+
+/** Number of needle characters handled by one block of the bit-parallel levenshtein. */
+#define LEVENSHTEIN_BLOCK    64
+
+/**
+ * Match vectors of the needle characters, for the bit-parallel levenshtein.
+ * Bit i of block b is set when needle character b * 64 + i equals the character.
+ */
+typedef struct
+{
+    /** Number of blocks. */
+    glong        blocks;
+    /** Bit c is set when ASCII character c is in the needle. */
+    guint64      ascii_set[2];
+    /** The vectors of the ASCII characters (only valid if in ascii_set). */
+    guint64      *ascii;
+    /** The distinct non ASCII needle characters. */
+    gunichar     *uchars;
+    /** Their vectors. */
+    guint64      *ubits;
+    unsigned int num_uchars;
+} LevenshteinPeq;
+
+static void levenshtein_peq_init ( LevenshteinPeq *peq, const gunichar *needles, glong needlelen )
+{
+    peq->ascii_set[0] = peq->ascii_set[1] = 0;
+    peq->num_uchars   = 0;
+    for ( glong y = 0; y < needlelen; y++ ) {
+        gunichar c     = needles[y];
+        guint64  *bits = NULL;
+        if ( c < 128 ) {
+            bits = &( peq->ascii[c * peq->blocks] );
+            if ( ( peq->ascii_set[c >> 6] & ( G_GUINT64_CONSTANT ( 1 ) << ( c & 63 ) ) ) == 0 ) {
+                peq->ascii_set[c >> 6] |= G_GUINT64_CONSTANT ( 1 ) << ( c & 63 );
+                memset ( bits, 0, peq->blocks * sizeof ( guint64 ) );
+            }
+        }
+        else {
+            unsigned int u = 0;
+            while ( u < peq->num_uchars && peq->uchars[u] != c ) {
+                u++;
+            }
+            bits = &( peq->ubits[u * peq->blocks] );
+            if ( u == peq->num_uchars ) {
+                peq->uchars[peq->num_uchars++] = c;
+                memset ( bits, 0, peq->blocks * sizeof ( guint64 ) );
+            }
+        }
+        bits[y / LEVENSHTEIN_BLOCK] |= G_GUINT64_CONSTANT ( 1 ) << ( y % LEVENSHTEIN_BLOCK );
+    }
+}
+
+/**
+ * @returns the vectors for c, NULL if c is not in the needle.
+ */
+static inline const guint64 *levenshtein_peq_get ( const LevenshteinPeq *peq, gunichar c )
+{
+    if ( c < 128 ) {
+        if ( peq->ascii_set[c >> 6] & ( G_GUINT64_CONSTANT ( 1 ) << ( c & 63 ) ) ) {
+            return &( peq->ascii[c * peq->blocks] );
+        }
+        return NULL;
+    }
+    for ( unsigned int u = 0; u < peq->num_uchars; u++ ) {
+        if ( peq->uchars[u] == c ) {
+            return &( peq->ubits[u * peq->blocks] );
+        }
+    }
+    return NULL;
+}
+
+unsigned int levenshtein_corpus_bounded ( const rofi_int_corpus_entry *needle, const rofi_int_corpus_entry *haystack, unsigned int max )
 {
+    const glong needlelen = needle->length;
     if ( needlelen  == G_MAXLONG ){
         // String to long, we cannot handle this.
         return UINT_MAX;
     }
-    unsigned int column[needlelen + 1];
-    for ( glong y = 0; y <= needlelen; y++ ) {
-        column[y] = y;
+    const glong haystacklen = haystack->length;
+    // The distance is at least the difference in length.
+    glong       diff = needlelen > haystacklen ? needlelen - haystacklen : haystacklen - needlelen;
+    if ( (gulong) diff > max ) {
+        return max + 1;
+    }
+    if ( needlelen == 0 || haystacklen == 0 ) {
+        return (unsigned int) diff;
+    }
+    const gunichar *needles   = needle->folded ? needle->folded : needle->chars;
+    const gunichar *haystacks = haystack->folded ? haystack->folded : haystack->chars;
+
+    // Myers' bit-vector algorithm, in the blocked form of Hyyrö.
+    // Block b holds the vertical deltas (+1 in pv, -1 in mv) of rows b * 64 + 1 to b * 64 + 64 of the current column.
+    LevenshteinPeq peq;
+    peq.blocks = ( needlelen + LEVENSHTEIN_BLOCK - 1 ) / LEVENSHTEIN_BLOCK;
+    guint64        s_ascii[128], s_ubits[LEVENSHTEIN_BLOCK], s_pv[1], s_mv[1];
+    gunichar       s_uchars[LEVENSHTEIN_BLOCK];
+    guint64        *pv, *mv;
+    if ( peq.blocks == 1 ) {
+        // Short needle, no need to allocate.
+        peq.ascii  = s_ascii;
+        peq.ubits  = s_ubits;
+        peq.uchars = s_uchars;
+        pv         = s_pv;
+        mv         = s_mv;
     }
-    for ( glong x = 1; x <= haystacklen; x++ ) {
-        const char *needles = needle;
-        column[0] = x;
-        gunichar   haystackc = g_utf8_get_char ( haystack );
-        if ( !config.case_sensitive ) {
-            haystackc = g_unichar_tolower ( haystackc );
-        }
-        for ( glong y = 1, lastdiag = x - 1; y <= needlelen; y++ ) {
-            gunichar needlec = g_utf8_get_char ( needles );
-            if ( !config.case_sensitive ) {
-                needlec = g_unichar_tolower ( needlec );
+    else {
+        peq.ascii  = g_malloc_n ( 128 * peq.blocks, sizeof ( guint64 ) );
+        peq.ubits  = g_malloc_n ( needlelen * peq.blocks, sizeof ( guint64 ) );
+        peq.uchars = g_malloc_n ( needlelen, sizeof ( gunichar ) );
+        pv         = g_malloc_n ( peq.blocks, sizeof ( guint64 ) );
+        mv         = g_malloc_n ( peq.blocks, sizeof ( guint64 ) );
+    }
+    levenshtein_peq_init ( &peq, needles, needlelen );
+    for ( glong b = 0; b < peq.blocks; b++ ) {
+        // Column 0 is 0, 1, 2, ...
+        pv[b] = G_MAXUINT64;
+        mv[b] = 0;
+    }
+    const guint64 last = G_GUINT64_CONSTANT ( 1 ) << ( ( needlelen - 1 ) % LEVENSHTEIN_BLOCK );
+    glong         score = needlelen;
+    for ( glong x = 0; x < haystacklen; x++ ) {
+        const guint64 *eqs = levenshtein_peq_get ( &peq, haystacks[x] );
+        // Row 0 is 0, 1, 2, ...: every column starts with a +1 horizontal delta.
+        int           hin = 1;
+        for ( glong b = 0; b < peq.blocks; b++ ) {
+            guint64 eq = eqs ? eqs[b] : 0;
+            guint64 xv = eq | mv[b];
+            if ( hin < 0 ) {
+                eq |= 1;
+            }
+            guint64 xh   = ( ( ( eq & pv[b] ) + pv[b] ) ^ pv[b] ) | eq;
+            guint64 ph   = mv[b] | ~( xh | pv[b] );
+            guint64 mh   = pv[b] & xh;
+            guint64 top  = ( b == peq.blocks - 1 ) ? last : ( G_GUINT64_CONSTANT ( 1 ) << 63 );
+            int     hout = ( ph & top ) ? 1 : ( ( mh & top ) ? -1 : 0 );
+            ph <<= 1;
+            mh <<= 1;
+            if ( hin < 0 ) {
+                mh |= 1;
+            }
+            else if ( hin > 0 ) {
+                ph |= 1;
             }
-            unsigned int olddiag = column[y];
-            column[y] = MIN3 ( column[y] + 1, column[y - 1] + 1, lastdiag + ( needlec == haystackc ? 0 : 1 ) );
-            lastdiag  = olddiag;
-            needles   = g_utf8_next_char ( needles );
+            pv[b] = mh | ~( xv | ph );
+            mv[b] = ph & xv;
+            hin   = hout;
         }
-        haystack = g_utf8_next_char ( haystack );
+        score += hin;
+        // Each remaining haystack character lowers the distance by at most one.
+        if ( (gint64) score - ( haystacklen - x - 1 ) > (gint64) max ) {
+            score = (glong) max + 1;
+            break;
+        }
+    }
+    if ( peq.blocks > 1 ) {
+        g_free ( peq.ascii );
+        g_free ( peq.ubits );
+        g_free ( peq.uchars );
+        g_free ( pv );
+        g_free ( mv );
+    }
+    return (unsigned int) score;
+}
+
+unsigned int levenshtein_corpus ( const rofi_int_corpus_entry *needle, const rofi_int_corpus_entry *haystack )
+{
+    return levenshtein_corpus_bounded ( needle, haystack, UINT_MAX );
+}
+
+unsigned int levenshtein ( const char *needle, const glong needlelen, const char *haystack, const glong haystacklen )
+{
+    if ( needlelen  == G_MAXLONG ){
+        // String to long, we cannot handle this.
+        return UINT_MAX;
     }
-    return column[needlelen];
+    rofi_int_corpus_entry n, h;
+    helper_corpus_entry_init ( &n, needle, config.case_sensitive );
+    helper_corpus_entry_init ( &h, haystack, config.case_sensitive );
+    n.length = MIN ( n.length, needlelen );
+    h.length = MIN ( h.length, haystacklen );
+    unsigned int retv = levenshtein_corpus ( &n, &h );
+    helper_corpus_entry_clear ( &n );
+    helper_corpus_entry_clear ( &h );
+    return retv;
 }
 
 char * rofi_latin_to_utf8_strdup ( const char *input, gssize length )
@@ -715,18 +1819,62 @@ char * rofi_latin_to_utf8_strdup ( const char *input, gssize length )
     return g_convert_with_fallback ( input, length, "UTF-8", "latin1", "\uFFFD", NULL, &slength, NULL );
 }
 
-char * rofi_force_utf8 ( const gchar *data, ssize_t length )
+/** Each byte set to 0x01. */
+#define UTF8_ONES     G_GUINT64_CONSTANT ( 0x0101010101010101 )
+/** Each byte set to 0x80. */
+#define UTF8_HIGHS    G_GUINT64_CONSTANT ( 0x8080808080808080 )
+
+/**
+ * @param data The data to check.
+ * @param length The length of data.
+ * @param end Set to the first invalid byte. [out]
+ *
+ * Skips the ASCII prefix a word (or vector) at a time, and validates the rest with g_utf8_validate().
+ *
+ * @returns TRUE when data is valid UTF-8 without embedded NUL bytes.
+ */
+static gboolean rofi_utf8_validate_end ( const char *data, gsize length, const char **end )
 {
-    if ( data == NULL ) {
-        return NULL;
+    gsize i = 0;
+#ifdef __SSE2__
+    const __m128i zero = _mm_setzero_si128 ();
+    for (; ( i + 16 ) <= length; i += 16 ) {
+        __m128i v = _mm_loadu_si128 ( (const __m128i *) ( data + i ) );
+        // A byte with the high bit set (not ASCII) or a NUL byte.
+        if ( _mm_movemask_epi8 ( _mm_or_si128 ( v, _mm_cmpeq_epi8 ( v, zero ) ) ) != 0 ) {
+            break;
+        }
     }
-    const char *end;
-    GString    *string;
-
-    if ( g_utf8_validate ( data, length, &end ) ) {
-        return g_memdup ( data, length + 1 );
+#endif
+    for (; ( i + 8 ) <= length; i += 8 ) {
+        guint64 v;
+        memcpy ( &v, data + i, sizeof ( guint64 ) );
+        // The high bit of a byte is set when it is not ASCII, or when it is NUL.
+        if ( ( ( v | ( ( v - UTF8_ONES ) & ~v ) ) & UTF8_HIGHS ) != 0 ) {
+            break;
+        }
     }
-    string = g_string_sized_new ( length + 16 );
+    // Everything before i is ASCII, validate the rest from this character boundary.
+    return g_utf8_validate ( data + i, length - i, end );
+}
+
+gboolean rofi_utf8_validate ( const char *data, gsize length )
+{
+    return rofi_utf8_validate_end ( data, length, NULL );
+}
+
+/**
+ * @param data The invalid data.
+ * @param length The length of data.
+ * @param end The first invalid byte in data.
+ *
+ * Replace the invalid sequences by the replacement character.
+ *
+ * @returns a newly allocated valid UTF-8 string.
+ */
+static char * rofi_force_utf8_replace ( const gchar *data, gssize length, const char *end )
+{
+    GString *string = g_string_sized_new ( length + 16 );
 
     do {
         /* Valid part of the string */
@@ -744,6 +1892,30 @@ char * rofi_force_utf8 ( const gchar *data, ssize_t length )
     return g_string_free ( string, FALSE );
 }
 
+char * rofi_force_utf8 ( const gchar *data, ssize_t length )
+{
+    if ( data == NULL ) {
+        return NULL;
+    }
+    const char *end;
+
+    if ( rofi_utf8_validate_end ( data, length, &end ) ) {
+        return g_memdup ( data, length + 1 );
+    }
+    return rofi_force_utf8_replace ( data, length, end );
+}
+
+char * rofi_force_utf8_take ( gchar *data, gsize length )
+{
+    const char *end;
+    if ( data == NULL || rofi_utf8_validate_end ( data, length, &end ) ) {
+        return data;
+    }
+    char *retv = rofi_force_utf8_replace ( data, length, end );
+    g_free ( data );
+    return retv;
+}
+
 /****
  * FZF like scorer
  */
@@ -803,6 +1975,27 @@ static enum CharClass rofi_scorer_get_character_class ( gunichar c )
     return NON_WORD;
 }
 
+/**
+ * @param c The ASCII character to determine class of
+ *
+ * Same as rofi_scorer_get_character_class(), without the unicode table lookups.
+ *
+ * @returns the class of the character c.
+ */
+static inline enum CharClass rofi_scorer_get_ascii_character_class ( gunichar c )
+{
+    if ( c >= 'a' && c <= 'z' ) {
+        return LOWER;
+    }
+    if ( c >= 'A' && c <= 'Z' ) {
+        return UPPER;
+    }
+    if ( c >= '0' && c <= '9' ) {
+        return DIGIT;
+    }
+    return NON_WORD;
+}
+
 /**
  * @param prev The previous character.
  * @param curr The current character
@@ -853,65 +2046,94 @@ static int rofi_scorer_get_score_for ( enum CharClass prev, enum CharClass curr
  *
  * @returns the sorting weight.
  */
-int rofi_scorer_fuzzy_evaluate ( const char *pattern, glong plen, const char *str, glong slen )
+int rofi_scorer_fuzzy_evaluate_corpus ( const rofi_int_corpus_entry *pattern, const rofi_int_corpus_entry *str )
 {
+    const glong plen = pattern->length;
+    const glong slen = str->length;
     if ( slen > FUZZY_SCORER_MAX_LENGTH ) {
         return -MIN_SCORE;
     }
-    glong    pi, si;
+    glong          pi, si;
     // whether we are aligning the first character of pattern
-    gboolean pfirst = TRUE;
+    gboolean       pfirst = TRUE;
     // whether the start of a word in pattern
-    gboolean pstart = TRUE;
+    gboolean       pstart = TRUE;
+    // str is never longer than FUZZY_SCORER_MAX_LENGTH, so the rows live on the (thread's) stack.
     // score for each position
-    int      *score = g_malloc_n ( slen, sizeof ( int ) );
-    // dp[i]: maximum value by aligning pattern[0..pi] to str[0..si]
-    int      *dp = g_malloc_n ( slen, sizeof ( int ) );
-    // uleft: value of the upper left cell; ulefts: maximum value of uleft and cells on the left. The arbitrary initial
-    // values suppress warnings.
-    int            uleft = 0, ulefts = 0, left, lefts;
-    const gchar    *pit = pattern, *sit;
-    enum CharClass prev = NON_WORD;
-    for ( si = 0, sit = str; si < slen; si++, sit = g_utf8_next_char ( sit ) ) {
-        enum CharClass cur       = rofi_scorer_get_character_class ( g_utf8_get_char ( sit ) );
+    int            score[FUZZY_SCORER_MAX_LENGTH];
+    // lefts[i]: maximum value of dp[0..i] of the previous row, including the gap penalty
+    int            lefts[FUZZY_SCORER_MAX_LENGTH];
+    // dp[i]: maximum value by aligning pattern[0..pi] to str[0..si], the previous row is kept in the other buffer.
+    int            rows[2][FUZZY_SCORER_MAX_LENGTH];
+    int            *dp = rows[0], *next = rows[1];
+    // uleft: value of the upper left cell; ulefts: maximum value of uleft and cells on the left, both of the last
+    // column. The arbitrary initial values suppress warnings.
+    int            uleft = 0, ulefts = 0, left;
+    // Compare the folded forms, the character classes need the original case.
+    const gunichar *pfolded = pattern->folded ? pattern->folded : pattern->chars;
+    const gunichar *sfolded = str->folded ? str->folded : str->chars;
+    enum CharClass prev     = NON_WORD;
+    for ( si = 0; si < slen; si++ ) {
+        gunichar       c   = str->chars[si];
+        enum CharClass cur = c < 0x80 ? rofi_scorer_get_ascii_character_class ( c ) : rofi_scorer_get_character_class ( c );
         score[si] = rofi_scorer_get_score_for ( prev, cur );
         prev      = cur;
         dp[si]    = MIN_SCORE;
     }
-    for ( pi = 0; pi < plen; pi++, pit = g_utf8_next_char ( pit ) ) {
-        gunichar pc = g_utf8_get_char ( pit ), sc;
-        if ( g_unichar_isspace ( pc ) ) {
+    for ( pi = 0; pi < plen && slen > 0; pi++ ) {
+        gunichar pc = pfolded[pi];
+        if ( g_unichar_isspace ( pattern->chars[pi] ) ) {
             pstart = TRUE;
             continue;
         }
-        lefts = MIN_SCORE;
-        for ( si = 0, sit = str; si < slen; si++, sit = g_utf8_next_char ( sit ) ) {
-            left  = dp[si];
-            lefts = MAX ( lefts + GAP_SCORE, left );
-            sc    = g_utf8_get_char ( sit );
-            if ( config.case_sensitive
-                 ? pc == sc
-                 : g_unichar_tolower ( pc ) == g_unichar_tolower ( sc ) ) {
-                int t = score[si] * ( pstart ? PATTERN_START_MULTIPLIER : PATTERN_NON_START_MULTIPLIER );
-                dp[si] = pfirst
-                         ? LEADING_GAP_SCORE * si + t
-                         : MAX ( uleft + CONSECUTIVE_SCORE, ulefts + t );
+        const int multiplier = pstart ? PATTERN_START_MULTIPLIER : PATTERN_NON_START_MULTIPLIER;
+        // The running maximum is the only loop carried dependency, compute it first so the loops
+        // below are independent per position.
+        left = MIN_SCORE;
+        for ( si = 0; si < slen; si++ ) {
+            left      = MAX ( left + GAP_SCORE, dp[si] );
+            lefts[si] = left;
+        }
+        if ( pfirst ) {
+            for ( si = 0; si < slen; si++ ) {
+                next[si] = ( pc == sfolded[si] ) ? LEADING_GAP_SCORE * si + score[si] * multiplier : MIN_SCORE;
             }
-            else {
-                dp[si] = MIN_SCORE;
+        }
+        else {
+            next[0] = ( pc == sfolded[0] ) ? MAX ( uleft + CONSECUTIVE_SCORE, ulefts + score[0] * multiplier ) : MIN_SCORE;
+            for ( si = 1; si < slen; si++ ) {
+                int t = MAX ( dp[si - 1] + CONSECUTIVE_SCORE, lefts[si - 1] + score[si] * multiplier );
+                next[si] = ( pc == sfolded[si] ) ? t : MIN_SCORE;
             }
-            uleft  = left;
-            ulefts = lefts;
         }
+        uleft  = dp[slen - 1];
+        ulefts = lefts[slen - 1];
+        int *tmp = dp;
+        dp     = next;
+        next   = tmp;
         pfirst = pstart = FALSE;
     }
-    lefts = MIN_SCORE;
+    left = MIN_SCORE;
     for ( si = 0; si < slen; si++ ) {
-        lefts = MAX ( lefts + GAP_SCORE, dp[si] );
+        left = MAX ( left + GAP_SCORE, dp[si] );
     }
-    g_free ( score );
-    g_free ( dp );
-    return -lefts;
+    return -left;
+}
+
+int rofi_scorer_fuzzy_evaluate ( const char *pattern, glong plen, const char *str, glong slen )
+{
+    if ( slen > FUZZY_SCORER_MAX_LENGTH ) {
+        return -MIN_SCORE;
+    }
+    rofi_int_corpus_entry p, s;
+    helper_corpus_entry_init ( &p, pattern, config.case_sensitive );
+    helper_corpus_entry_init ( &s, str, config.case_sensitive );
+    p.length = MIN ( p.length, plen );
+    s.length = MIN ( s.length, slen );
+    int retv = rofi_scorer_fuzzy_evaluate_corpus ( &p, &s );
+    helper_corpus_entry_clear ( &p );
+    helper_corpus_entry_clear ( &s );
+    return retv;
 }
 
 /**
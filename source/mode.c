@@ -83,6 +83,15 @@ char * mode_get_completion ( const Mode *mode, unsigned int selected_line )
     }
 }
 
+const char * mode_get_completion_string ( const Mode *mode, unsigned int selected_line )
+{
+    g_assert ( mode != NULL );
+    if ( mode->_get_completion_string != NULL ) {
+        return mode->_get_completion_string ( mode, selected_line );
+    }
+    return NULL;
+}
+
 ModeMode mode_result ( Mode *mode, int menu_retv, char **input, unsigned int selected_line )
 {
     g_assert ( mode != NULL );
@@ -91,13 +100,32 @@ ModeMode mode_result ( Mode *mode, int menu_retv, char **input, unsigned int sel
     return mode->_result ( mode, menu_retv, input, selected_line );
 }
 
-int mode_token_match ( const Mode *mode, GRegex **tokens, unsigned int selected_line )
+int mode_token_match ( const Mode *mode, rofi_int_matcher **tokens, unsigned int selected_line )
 {
     g_assert ( mode != NULL );
     g_assert ( mode->_token_match != NULL );
     return mode->_token_match ( mode, tokens, selected_line );
 }
 
+guint64 mode_get_match_signature ( const Mode *mode, unsigned int selected_line )
+{
+    g_assert ( mode != NULL );
+    if ( mode->_get_signature != NULL ) {
+        return mode->_get_signature ( mode, selected_line );
+    }
+    return G_MAXUINT64;
+}
+
+unsigned int *mode_get_candidates ( const Mode *mode, rofi_int_matcher **tokens, unsigned int *length )
+{
+    g_assert ( mode != NULL );
+    g_assert ( length != NULL );
+    if ( mode->_get_candidates != NULL ) {
+        return mode->_get_candidates ( mode, tokens, length );
+    }
+    return NULL;
+}
+
 const char *mode_get_name ( const Mode *mode )
 {
     g_assert ( mode != NULL );
@@ -111,6 +111,8 @@ struct
     workarea           mon;
     /** timeout for reloading */
     guint              idle_timeout;
+    /** If only entries were appended since idle_timeout was set. */
+    gboolean           reload_append;
     /** debug counter for redraws */
     unsigned long long count;
     /** redraw idle time. */
@@ -126,6 +128,7 @@ struct
     .flags          = MENU_NORMAL,
     .views          = G_QUEUE_INIT,
     .idle_timeout   =               0,
+    .reload_append  = FALSE,
     .count          =              0L,
     .repaint_source =               0,
     .fullscreen     = FALSE,
@@ -158,16 +161,325 @@ static char * get_matching_state ( void )
     return " ";
 }
 
+/**
+ * Structure with data to process by each worker thread.
+ */
+typedef struct _thread_state
+{
+    RofiViewState               *state;
+    unsigned int                start;
+    unsigned int                stop;
+    unsigned int                count;
+    GCond                       *cond;
+    GMutex                      *mutex;
+    /** Number of workers still running, shared by the workers of a job. */
+    volatile gint               *acount;
+    /** Set (with mutex held) when the last worker finished. */
+    gboolean                    *finished;
+
+    const rofi_int_corpus_entry *pattern;
+    guint64                     signature;
+    const unsigned int          *candidates;
+    /** Where to store the matching entries. */
+    unsigned int                *line_map;
+    /** Where to store their sort keys, NULL when not sorting. */
+    guint64                     *sort_keys;
+    /** Stop when state->filter_generation no longer equals this. */
+    gint                        generation;
+    void                        ( *callback )( struct _thread_state *t, gpointer data );
+    /** Called (with mutex held) by the worker finishing last, can be NULL. */
+    void                        ( *finalize )( struct _thread_state *t );
+    /** Data for callback and finalize. */
+    gpointer                    data;
+}thread_state;
+/**
+ * @param data A thread_state object.
+ * @param user_data User data to pass to thread_state callback
+ *
+ * Small wrapper function that is internally used to pass a job to a worker.
+ */
+static void rofi_view_call_thread ( gpointer data, gpointer user_data )
+{
+    thread_state *t = (thread_state *) data;
+    t->callback ( t, user_data );
+    // Only the last worker takes the lock, to wake up the waiting thread.
+    if ( g_atomic_int_dec_and_test ( t->acount ) ) {
+        g_mutex_lock ( t->mutex );
+        if ( t->finalize != NULL ) {
+            t->finalize ( t );
+        }
+        *( t->finished ) = TRUE;
+        g_cond_signal ( t->cond );
+        g_mutex_unlock ( t->mutex );
+    }
+}
+
+/**
+ * @param distance The levenshtein distance or fuzzy score (lower is better).
+ * @param index The index of the entry.
+ *
+ * Pack the distance and index into a key, so sorting the keys orders on distance and keeps ties in list order.
+ */
+#define SORT_KEY( distance, index )    ( ( (guint64) ( ( (guint32) ( distance ) ) ^ 0x80000000u ) << 32 ) | ( index ) )
+/** The entry index of a sort key. */
+#define SORT_KEY_INDEX( key )          ( (unsigned int) ( ( key ) & G_MAXUINT32 ) )
+/** Number of entries sorted at once, should cover the visible rows. */
+#define SORT_CHUNK                     256
+/** Above this many unsorted entries, all are sorted using sort_keys_radix(). */
+#define RADIX_SORT_MIN_LENGTH          4096
+/** Minimum number of keys per radix sort worker. */
+#define RADIX_SORT_CHUNK               65536
+
 /**
  * Levenshtein Sorting.
  */
-static int lev_sort ( const void *p1, const void *p2, void *arg )
+static int lev_sort ( const void *p1, const void *p2, G_GNUC_UNUSED void *arg )
+{
+    const guint64 *a = p1;
+    const guint64 *b = p2;
+
+    return ( *a > *b ) - ( *a < *b );
+}
+
+/**
+ * @param keys The sort keys.
+ * @param length The number of keys.
+ * @param k The number of keys wanted in order.
+ *
+ * Partially sort keys: the k smallest keys are moved to the front in order, the others follow in any order.
+ * Uses quickselect (falling back to sorting when partitioning goes bad), so this is O(length + k log k).
+ */
+static void sort_keys_select ( guint64 *keys, unsigned int length, unsigned int k )
+{
+    unsigned int lo    = 0;
+    unsigned int hi    = length;
+    unsigned int depth = 2 * g_bit_storage ( length );
+    k = MIN ( k, length );
+    while ( k < hi && lo < k && ( hi - lo ) > 16 ) {
+        if ( depth-- == 0 ) {
+            g_qsort_with_data ( &( keys[lo] ), hi - lo, sizeof ( guint64 ), lev_sort, NULL );
+            break;
+        }
+        // Median of three, keys are unique.
+        guint64      a     = keys[lo];
+        guint64      b     = keys[lo + ( hi - lo ) / 2];
+        guint64      c     = keys[hi - 1];
+        guint64      pivot = MAX ( MIN ( a, b ), MIN ( MAX ( a, b ), c ) );
+        unsigned int lt    = lo;
+        unsigned int gt    = hi;
+        unsigned int i     = lo;
+        while ( i < gt ) {
+            guint64 key = keys[i];
+            if ( key < pivot ) {
+                keys[i++]  = keys[lt];
+                keys[lt++] = key;
+            }
+            else if ( key > pivot ) {
+                keys[i]  = keys[--gt];
+                keys[gt] = key;
+            }
+            else {
+                i++;
+            }
+        }
+        // [lo,lt) < pivot, [lt,gt) == pivot, [gt,hi) > pivot.
+        if ( k < lt ) {
+            hi = lt;
+        }
+        else if ( k > gt ) {
+            lo = gt;
+        }
+        else {
+            break;
+        }
+    }
+    if ( lo < k && k < hi && ( hi - lo ) <= 16 ) {
+        g_qsort_with_data ( &( keys[lo] ), hi - lo, sizeof ( guint64 ), lev_sort, NULL );
+    }
+    g_qsort_with_data ( keys, k, sizeof ( guint64 ), lev_sort, NULL );
+}
+
+/**
+ * State shared by the workers of a radix sort pass.
+ */
+typedef struct
+{
+    /** Sort keys to distribute. */
+    guint64      *keys;
+    /** Destination of the pass. */
+    guint64      *buffer;
+    /** The byte of the key used by this pass. */
+    unsigned int shift;
+    /** If this is the distribution step, otherwise the counting step. */
+    gboolean     scatter;
+    /** Per worker count of each byte value, turned into the worker's destination offsets. */
+    unsigned int ( *counts )[256];
+    thread_state *states;
+} RadixSortJob;
+
+static void radix_sort_elements ( thread_state *t, G_GNUC_UNUSED gpointer user_data )
+{
+    RadixSortJob *job    = (RadixSortJob *) t->data;
+    unsigned int *counts = job->counts[t - job->states];
+    if ( job->scatter ) {
+        for ( unsigned int k = t->start; k < t->stop; k++ ) {
+            job->buffer[counts[( job->keys[k] >> job->shift ) & 0xFF]++] = job->keys[k];
+        }
+    }
+    else {
+        memset ( counts, 0, 256 * sizeof ( unsigned int ) );
+        for ( unsigned int k = t->start; k < t->stop; k++ ) {
+            counts[( job->keys[k] >> job->shift ) & 0xFF]++;
+        }
+    }
+}
+
+/**
+ * @param states The jobs.
+ * @param nt The number of jobs.
+ *
+ * Run the jobs on the thread pool (and the calling thread) and wait until all are done.
+ */
+static void rofi_view_run_threads ( thread_state *states, unsigned int nt )
+{
+    GCond    cond;
+    GMutex   mutex;
+    gint     count    = nt;
+    gboolean finished = FALSE;
+    g_mutex_init ( &mutex );
+    g_cond_init ( &cond );
+    for ( unsigned int i = 0; i < nt; i++ ) {
+        states[i].cond     = &cond;
+        states[i].mutex    = &mutex;
+        states[i].acount   = &count;
+        states[i].finished = &finished;
+        if ( i > 0 ) {
+            g_thread_pool_push ( tpool, &states[i], NULL );
+        }
+    }
+    // Run one in this thread.
+    rofi_view_call_thread ( &states[0], NULL );
+    // No need to do this with only one thread.
+    if ( nt > 1 ) {
+        g_mutex_lock ( &mutex );
+        while ( !finished ) {
+            g_cond_wait ( &cond, &mutex );
+        }
+        g_mutex_unlock ( &mutex );
+    }
+    g_cond_clear ( &cond );
+    g_mutex_clear ( &mutex );
+}
+
+/**
+ * @param keys The sort keys.
+ * @param length The number of keys.
+ * @param threads The maximum number of threads to use.
+ *
+ * Sort keys with a least significant digit radix sort, one pass per byte that differs between keys.
+ * Each pass is split over the thread pool: every worker counts the bytes in its part,
+ * then places its keys after those of the workers before it, so each pass is stable.
+ */
+static void sort_keys_radix ( guint64 *keys, unsigned int length, unsigned int threads )
+{
+    guint64 all_or  = 0;
+    guint64 all_and = G_MAXUINT64;
+    for ( unsigned int i = 0; i < length; i++ ) {
+        all_or  |= keys[i];
+        all_and &= keys[i];
+    }
+    unsigned int nt    = MAX ( 1, MIN ( threads, length / RADIX_SORT_CHUNK ) );
+    unsigned int steps = ( length + nt ) / nt;
+    RadixSortJob job   = { .keys = keys, .buffer = g_malloc_n ( length, sizeof ( guint64 ) ) };
+    job.counts = g_malloc_n ( nt, sizeof ( *job.counts ) );
+    job.states = g_malloc0_n ( nt, sizeof ( thread_state ) );
+    for ( unsigned int i = 0; i < nt; i++ ) {
+        job.states[i].start    = i * steps;
+        job.states[i].stop     = MIN ( length, ( i + 1 ) * steps );
+        job.states[i].callback = radix_sort_elements;
+        job.states[i].data     = &job;
+    }
+    for ( job.shift = 0; job.shift < 64; job.shift += 8 ) {
+        if ( ( ( ( all_or ^ all_and ) >> job.shift ) & 0xFF ) == 0 ) {
+            // All keys have the same value for this byte.
+            continue;
+        }
+        job.scatter = FALSE;
+        rofi_view_run_threads ( job.states, nt );
+        // Turn the counts into offsets: by byte value, then by worker.
+        unsigned int offset = 0;
+        for ( unsigned int b = 0; b < 256; b++ ) {
+            for ( unsigned int i = 0; i < nt; i++ ) {
+                unsigned int c = job.counts[i][b];
+                job.counts[i][b] = offset;
+                offset          += c;
+            }
+        }
+        job.scatter = TRUE;
+        rofi_view_run_threads ( job.states, nt );
+        guint64 *swap = job.keys;
+        job.keys   = job.buffer;
+        job.buffer = swap;
+    }
+    if ( job.keys != keys ) {
+        memcpy ( keys, job.keys, length * sizeof ( guint64 ) );
+        job.buffer = job.keys;
+    }
+    g_free ( job.buffer );
+    g_free ( job.counts );
+    g_free ( job.states );
+}
+
+/**
+ * @param state The view state.
+ * @param needed The number of filtered elements that should be in order.
+ *
+ * Sorting only orders the first rows, order more of them when they are shown.
+ */
+static void rofi_view_sort_lines ( RofiViewState *state, unsigned int needed )
+{
+    if ( needed <= state->sorted_lines ) {
+        return;
+    }
+    unsigned int sorted = state->sorted_lines;
+    unsigned int length = state->filtered_lines - sorted;
+    unsigned int k      = MIN ( length, MAX ( needed - sorted, SORT_CHUNK ) );
+    if ( length > RADIX_SORT_MIN_LENGTH ) {
+        // Paging further usually continues, order all at once.
+        // The pool is busy with a running filter job, then sort in this thread.
+        sort_keys_radix ( &( state->sort_keys[sorted] ), length, state->filter_job != NULL ? 1 : config.threads );
+        k = length;
+    }
+    else {
+        sort_keys_select ( &( state->sort_keys[sorted] ), length, k );
+    }
+    for ( unsigned int i = sorted; i < state->filtered_lines; i++ ) {
+        state->line_map[i] = SORT_KEY_INDEX ( state->sort_keys[i] );
+    }
+    state->sorted_lines = sorted + k;
+}
+
+/**
+ * @param state The view state.
+ * @param pos The position in the filtered list.
+ *
+ * @returns the index of the entry shown at pos.
+ */
+static unsigned int rofi_view_get_line ( RofiViewState *state, unsigned int pos )
 {
-    const int *a         = p1;
-    const int *b         = p2;
-    int       *distances = arg;
+    rofi_view_sort_lines ( state, pos + 1 );
+    return state->line_map[pos];
+}
 
-    return distances[*a] - distances[*b];
+/**
+ * Sort on index.
+ */
+static int index_sort ( const void *p1, const void *p2, G_GNUC_UNUSED void *arg )
+{
+    const unsigned int *a = p1;
+    const unsigned int *b = p2;
+
+    return ( *a > *b ) - ( *a < *b );
 }
 
 /**
@@ -394,21 +706,43 @@ static void rofi_view_reload_message_bar ( RofiViewState *state )
 static gboolean rofi_view_reload_idle ( G_GNUC_UNUSED gpointer data )
 {
     if ( current_active_menu ) {
-        current_active_menu->reload   = TRUE;
+        if ( CacheState.reload_append ) {
+            current_active_menu->reload_append = TRUE;
+        }
+        else {
+            current_active_menu->reload = TRUE;
+        }
         current_active_menu->refilter = TRUE;
         rofi_view_queue_redraw ();
     }
-    CacheState.idle_timeout = 0;
+    CacheState.idle_timeout  = 0;
+    CacheState.reload_append = FALSE;
     return G_SOURCE_REMOVE;
 }
 
+static void rofi_view_filter_job_wait ( RofiViewState *state, gboolean cancel );
+void rofi_view_filter_cancel ( void )
+{
+    if ( current_active_menu ) {
+        rofi_view_filter_job_wait ( current_active_menu, TRUE );
+    }
+}
+
 void rofi_view_reload ( void  )
 {
     // @TODO add check if current view is equal to the callee
+    CacheState.reload_append = FALSE;
     if ( CacheState.idle_timeout == 0 ) {
         CacheState.idle_timeout = g_timeout_add ( 1000 / 10, rofi_view_reload_idle, NULL );
     }
 }
+void rofi_view_reload_append ( void  )
+{
+    if ( CacheState.idle_timeout == 0 ) {
+        CacheState.reload_append = TRUE;
+        CacheState.idle_timeout  = g_timeout_add ( 1000 / 10, rofi_view_reload_idle, NULL );
+    }
+}
 void rofi_view_queue_redraw ( void  )
 {
     if ( current_active_menu && CacheState.repaint_source == 0 ) {
@@ -457,8 +791,18 @@ void rofi_view_set_selected_line ( RofiViewState *state, unsigned int selected_l
     state->selected_line = selected_line;
     // Find the line.
     unsigned int selected = 0;
-    for ( unsigned int i = 0; ( ( state->selected_line ) ) < UINT32_MAX && !selected && i < state->filtered_lines; i++ ) {
+    for ( unsigned int i = 0; ( ( state->selected_line ) ) < UINT32_MAX && i < state->filtered_lines; i++ ) {
         if ( state->line_map[i] == ( state->selected_line ) ) {
+            if ( i >= state->sorted_lines ) {
+                // Unsorted part, its row is the number of smaller keys: only order up to there.
+                guint64      key  = state->sort_keys[i];
+                unsigned int rank = state->sorted_lines;
+                for ( unsigned int j = state->sorted_lines; j < state->filtered_lines; j++ ) {
+                    rank += ( state->sort_keys[j] < key );
+                }
+                rofi_view_sort_lines ( state, rank + 1 );
+                i = rank;
+            }
             selected = i;
             break;
         }
@@ -468,19 +812,249 @@ void rofi_view_set_selected_line ( RofiViewState *state, unsigned int selected_l
     xcb_flush ( xcb->connection );
 }
 
+/**
+ * @param state The view state.
+ *
+ * Forget the previous filter, so the next one checks all entries.
+ */
+static void rofi_view_filter_reset ( RofiViewState *state )
+{
+    g_free ( state->filter_text );
+    g_free ( state->filter_pattern );
+    state->filter_text    = NULL;
+    state->filter_pattern = NULL;
+}
+
+/**
+ * @param state The view state.
+ *
+ * Free the decoded entries used for sorting.
+ */
+static void rofi_view_corpus_free ( RofiViewState *state )
+{
+    if ( state->corpus != NULL ) {
+        for ( unsigned int i = 0; i < state->num_lines; i++ ) {
+            helper_corpus_entry_clear ( &( state->corpus[i] ) );
+        }
+        g_free ( state->corpus );
+        state->corpus = NULL;
+    }
+}
+
+/** Maximum number of entries in RofiViewState::highlight_cache. */
+#define HIGHLIGHT_CACHE_SIZE    1024
+
+/**
+ * Highlighted ranges of a drawn entry, kept in RofiViewState::highlight_cache.
+ */
+typedef struct
+{
+    /** The text the ranges were found on. */
+    char   *text;
+    /** Array of #rofi_range_pair. */
+    GArray *ranges;
+} HighlightCacheEntry;
+
+static void highlight_cache_entry_free ( gpointer data )
+{
+    HighlightCacheEntry *entry = (HighlightCacheEntry *) data;
+    g_free ( entry->text );
+    g_array_free ( entry->ranges, TRUE );
+    g_free ( entry );
+}
+
+/**
+ * @param state The view state.
+ *
+ * Drop the remembered highlights, f.e. because the tokens changed.
+ */
+static void rofi_view_highlight_cache_clear ( RofiViewState *state )
+{
+    if ( state->highlight_cache != NULL ) {
+        g_hash_table_remove_all ( state->highlight_cache );
+    }
+}
+
+/**
+ * @param state The view state.
+ * @param line  The (unfiltered) entry.
+ * @param text  The displayed text of the entry.
+ *
+ * Get the ranges of text matched by the current tokens. These are only searched the first time
+ * the entry is drawn for the tokens, moving the selection or scrolling back re-uses them.
+ *
+ * @returns the matched ranges, owned by the cache.
+ */
+static const GArray *rofi_view_get_highlight_ranges ( RofiViewState *state, unsigned int line, const char *text )
+{
+    if ( state->highlight_cache == NULL ) {
+        state->highlight_cache = g_hash_table_new_full ( g_direct_hash, g_direct_equal, NULL, highlight_cache_entry_free );
+    }
+    HighlightCacheEntry *entry = g_hash_table_lookup ( state->highlight_cache, GUINT_TO_POINTER ( line ) );
+    // The mode can change the displayed text, f.e. a window title.
+    if ( entry != NULL && g_strcmp0 ( entry->text, text ) == 0 ) {
+        return entry->ranges;
+    }
+    if ( entry == NULL && g_hash_table_size ( state->highlight_cache ) >= HIGHLIGHT_CACHE_SIZE ) {
+        g_hash_table_remove_all ( state->highlight_cache );
+    }
+    entry         = g_malloc ( sizeof ( HighlightCacheEntry ) );
+    entry->text   = g_strdup ( text );
+    entry->ranges = helper_token_match_get_ranges ( state->tokens, text );
+    g_hash_table_replace ( state->highlight_cache, GUINT_TO_POINTER ( line ), entry );
+    return entry->ranges;
+}
+
+/**
+ * Result of a previous filter, kept in RofiViewState::filter_cache.
+ */
+typedef struct
+{
+    /** The mode that was filtered. */
+    const Mode     *sw;
+    /** The user input. */
+    char           *text;
+    /** Settings the result depends on. */
+    MatchingMethod matching_method;
+    unsigned int   case_sensitive;
+    unsigned int   sort;
+    unsigned int   levenshtein_sort;
+    /** The matching entries, in display order. */
+    unsigned int   *line_map;
+    /** The sort keys (same order as line_map), NULL when not sorting. */
+    guint64        *sort_keys;
+    /** Number of matching entries. */
+    unsigned int   length;
+    /** Number of entries in final order. */
+    unsigned int   sorted;
+} FilterCacheEntry;
+
+/**
+ * @param entry The cache entry.
+ *
+ * @returns the memory (in bytes) used by entry.
+ */
+static gsize filter_cache_entry_size ( const FilterCacheEntry *entry )
+{
+    return sizeof ( FilterCacheEntry ) + strlen ( entry->text ) + 1 + entry->length * ( sizeof ( unsigned int ) + sizeof ( guint64 ) );
+}
+
+static void filter_cache_entry_free ( FilterCacheEntry *entry )
+{
+    g_free ( entry->text );
+    g_free ( entry->line_map );
+    g_free ( entry->sort_keys );
+    g_free ( entry );
+}
+
+/**
+ * @param state The view state.
+ *
+ * Drop all remembered filter results, f.e. because the entries changed.
+ */
+static void rofi_view_filter_cache_clear ( RofiViewState *state )
+{
+    FilterCacheEntry *entry;
+    while ( ( entry = g_queue_pop_head ( &( state->filter_cache ) ) ) != NULL ) {
+        filter_cache_entry_free ( entry );
+    }
+    state->filter_cache_size = 0;
+}
+
+/**
+ * @param state The view state.
+ *
+ * If the current input was filtered before, restore line_map, sort_keys and filtered_lines from the cache.
+ *
+ * @returns TRUE when the result was restored.
+ */
+static gboolean rofi_view_filter_cache_restore ( RofiViewState *state )
+{
+    for ( GList *iter = state->filter_cache.head; iter != NULL; iter = g_list_next ( iter ) ) {
+        FilterCacheEntry *entry = iter->data;
+        if ( entry->sw == state->sw && entry->matching_method == config.matching_method &&
+             entry->case_sensitive == config.case_sensitive && entry->sort == config.sort &&
+             entry->levenshtein_sort == config.levenshtein_sort && g_strcmp0 ( entry->text, state->text->text ) == 0 ) {
+            memcpy ( state->line_map, entry->line_map, entry->length * sizeof ( unsigned int ) );
+            if ( entry->sort_keys != NULL ) {
+                memcpy ( state->sort_keys, entry->sort_keys, entry->length * sizeof ( guint64 ) );
+            }
+            state->filtered_lines = entry->length;
+            state->sorted_lines   = entry->sorted;
+            // Move to the front, so it is evicted last.
+            g_queue_unlink ( &( state->filter_cache ), iter );
+            g_queue_push_head_link ( &( state->filter_cache ), iter );
+            return TRUE;
+        }
+    }
+    return FALSE;
+}
+
+/**
+ * @param state The view state.
+ * @param text The user input that was filtered.
+ *
+ * Remember the current filter result, evicting the least recently used ones when over config.filter_cache_size.
+ */
+static void rofi_view_filter_cache_store ( RofiViewState *state, const char *text )
+{
+    gsize            max   = (gsize) config.filter_cache_size * 1024;
+    FilterCacheEntry *entry = g_malloc0 ( sizeof ( FilterCacheEntry ) );
+    entry->sw               = state->sw;
+    entry->text             = g_strdup ( text );
+    entry->matching_method  = config.matching_method;
+    entry->case_sensitive   = config.case_sensitive;
+    entry->sort             = config.sort;
+    entry->levenshtein_sort = config.levenshtein_sort;
+    entry->length           = state->filtered_lines;
+    gsize size = filter_cache_entry_size ( entry );
+    if ( size > max ) {
+        g_free ( entry->text );
+        g_free ( entry );
+        return;
+    }
+    entry->line_map = g_memdup ( state->line_map, entry->length * sizeof ( unsigned int ) );
+    entry->sorted   = state->sorted_lines;
+    if ( entry->sort ) {
+        // Also when all are in order, appending entries sorts them again.
+        entry->sort_keys = g_memdup ( state->sort_keys, entry->length * sizeof ( guint64 ) );
+    }
+    while ( state->filter_cache_size + size > max ) {
+        FilterCacheEntry *old = g_queue_pop_tail ( &( state->filter_cache ) );
+        state->filter_cache_size -= filter_cache_entry_size ( old );
+        filter_cache_entry_free ( old );
+    }
+    g_queue_push_head ( &( state->filter_cache ), entry );
+    state->filter_cache_size += size;
+}
+
 void rofi_view_free ( RofiViewState *state )
 {
+    if ( state->refilter_timeout > 0 ) {
+        g_source_remove ( state->refilter_timeout );
+        state->refilter_timeout = 0;
+    }
+    // Workers use the entries and tokens.
+    rofi_view_filter_job_wait ( state, TRUE );
     if ( state->tokens ) {
         tokenize_free ( state->tokens );
         state->tokens = NULL;
     }
+    g_free ( state->tokens_pattern );
     // Do this here?
     // Wait for final release?
     widget_free ( WIDGET ( state->main_window ) );
     widget_free ( WIDGET ( state->overlay ) );
 
     g_free ( state->line_map );
-    g_free ( state->distance );
+    g_free ( state->sort_keys );
+    g_free ( state->signatures );
+    rofi_view_corpus_free ( state );
+    rofi_view_filter_reset ( state );
+    rofi_view_filter_cache_clear ( state );
+    if ( state->highlight_cache != NULL ) {
+        g_hash_table_destroy ( state->highlight_cache );
+    }
     // Free the switcher boxes.
     // When state is free'ed we should no longer need these.
     if ( config.sidebar_mode == TRUE ) {
@@ -500,12 +1074,12 @@ unsigned int rofi_view_get_selected_line ( const RofiViewState *state )
     return state->selected_line;
 }
 
-unsigned int rofi_view_get_next_position ( const RofiViewState *state )
+unsigned int rofi_view_get_next_position ( RofiViewState *state )
 {
     unsigned int next_pos = state->selected_line;
     unsigned int selected = listview_get_selected ( state->list_view );
     if ( ( selected + 1 ) < state->num_lines ) {
-        ( next_pos ) = state->line_map[selected + 1];
+        ( next_pos ) = rofi_view_get_line ( state, selected + 1 );
     }
     return next_pos;
 }
@@ -532,57 +1106,63 @@ static RofiViewState * __rofi_view_state_create ( void )
 {
     return g_malloc0 ( sizeof ( RofiViewState ) );
 }
-/**
- * Structure with data to process by each worker thread.
- */
-typedef struct _thread_state
-{
-    RofiViewState *state;
-    unsigned int  start;
-    unsigned int  stop;
-    unsigned int  count;
-    GCond         *cond;
-    GMutex        *mutex;
-    unsigned int  *acount;
-
-    const char    *pattern;
-    glong         plen;
-    void ( *callback )( struct _thread_state *t, gpointer data );
-}thread_state;
-/**
- * @param data A thread_state object.
- * @param user_data User data to pass to thread_state callback
- *
- * Small wrapper function that is internally used to pass a job to a worker.
- */
-static void rofi_view_call_thread ( gpointer data, gpointer user_data )
-{
-    thread_state *t = (thread_state *) data;
-    t->callback ( t, user_data );
-    g_mutex_lock ( t->mutex );
-    ( *( t->acount ) )--;
-    g_cond_signal ( t->cond );
-    g_mutex_unlock ( t->mutex );
-}
+/** Number of entries a worker checks between looking if the filter was cancelled. */
+#define FILTER_CANCEL_CHUNK         256
+/** Number of entries a filter worker takes at a time. Smaller chunks even out slow entries better, larger ones cost less. */
+#define FILTER_CHUNK                512
+/** Minimum number of matches per thread when merging the results of the filter workers. */
+#define FILTER_MERGE_CHUNK          65536
+/** Longest (us) a filter is deferred by config.lazy_filter_limit. */
+#define LAZY_FILTER_MAX_DELAY       250000
+/** Pauses (us) between key presses longer than this end a burst of typing. */
+#define LAZY_FILTER_MAX_INTERVAL    1000000
 
 static void filter_elements ( thread_state *t, G_GNUC_UNUSED gpointer user_data )
 {
-    for ( unsigned int i = t->start; i < t->stop; i++ ) {
+    for ( unsigned int k = t->start; k < t->stop; k++ ) {
+        if ( ( ( k - t->start ) % FILTER_CANCEL_CHUNK ) == 0 && g_atomic_int_get ( &( t->state->filter_generation ) ) != t->generation ) {
+            // A newer filter was requested, the result will be discarded.
+            break;
+        }
+        // start and stop index the candidates, when there are.
+        unsigned int i = t->candidates ? t->candidates[k] : k;
+        if ( t->signature != 0 ) {
+            // Skip entries that miss characters of the query.
+            guint64 *signature = &( t->state->signatures[i] );
+            if ( *signature == 0 ) {
+                *signature = mode_get_match_signature ( t->state->sw, i );
+            }
+            if ( ( *signature & t->signature ) != t->signature ) {
+                continue;
+            }
+        }
         int match = mode_token_match ( t->state->sw, t->state->tokens, i );
         // If each token was matched, add it to list.
         if ( match ) {
-            t->state->line_map[t->start + t->count] = i;
-            if ( config.sort ) {
-                // This is inefficient, need to fix it.
-                char  * str = mode_get_completion ( t->state->sw, i );
-                glong slen  = g_utf8_strlen ( str, -1 );
+            t->line_map[t->count] = i;
+            if ( t->sort_keys != NULL ) {
+                rofi_int_corpus_entry *entry = &( t->state->corpus[i] );
+                // Decode the entry once, it is re-used on the following key presses.
+                // Each entry is only visited by one thread.
+                if ( entry->chars == NULL ) {
+                    const char *cstr = mode_get_completion_string ( t->state->sw, i );
+                    if ( cstr != NULL ) {
+                        helper_corpus_entry_init ( entry, cstr, t->state->corpus_case_sensitive );
+                    }
+                    else {
+                        char *str = mode_get_completion ( t->state->sw, i );
+                        helper_corpus_entry_init ( entry, str, t->state->corpus_case_sensitive );
+                        g_free ( str );
+                    }
+                }
+                int distance;
                 if ( config.levenshtein_sort || config.matching_method != MM_FUZZY  ) {
-                    t->state->distance[i] = levenshtein ( t->pattern, t->plen, str, slen );
+                    distance = levenshtein_corpus ( t->pattern, entry );
                 }
                 else {
-                    t->state->distance[i] = rofi_scorer_fuzzy_evaluate ( t->pattern, t->plen, str, slen );
+                    distance = rofi_scorer_fuzzy_evaluate_corpus ( t->pattern, entry );
                 }
-                g_free ( str );
+                t->sort_keys[t->count] = SORT_KEY ( distance, i );
             }
             t->count++;
         }
@@ -824,7 +1404,7 @@ static void rofi_view_nav_row_tab ( RofiViewState *state )
 {
     if ( state->filtered_lines == 1 ) {
         state->retv              = MENU_OK;
-        ( state->selected_line ) = state->line_map[listview_get_selected ( state->list_view )];
+        ( state->selected_line ) = rofi_view_get_line ( state, listview_get_selected ( state->list_view ) );
         state->quit              = 1;
         return;
     }
@@ -853,11 +1433,12 @@ inline static void rofi_view_nav_row_select ( RofiViewState *state )
     unsigned int selected = listview_get_selected ( state->list_view );
     // If a valid item is selected, return that..
     if ( selected < state->filtered_lines ) {
-        char *str = mode_get_completion ( state->sw, state->line_map[selected] );
+        char *str = mode_get_completion ( state->sw, rofi_view_get_line ( state, selected ) );
         textbox_text ( state->text, str );
         g_free ( str );
         textbox_keybinding ( state->text, MOVE_END );
-        state->refilter = TRUE;
+        state->refilter       = TRUE;
+        state->refilter_input = TRUE;
     }
 }
 
@@ -891,9 +1472,10 @@ static void update_callback ( textbox *t, unsigned int index, void *udata, TextB
 {
     RofiViewState *state = (RofiViewState *) udata;
     if ( full ) {
-        GList *add_list = NULL;
-        int   fstate    = 0;
-        char  *text     = mode_get_display_value ( state->sw, state->line_map[index], &fstate, &add_list, TRUE );
+        GList        *add_list = NULL;
+        int          fstate    = 0;
+        unsigned int line      = rofi_view_get_line ( state, index );
+        char         *text     = mode_get_display_value ( state->sw, line, &fstate, &add_list, TRUE );
         type |= fstate;
         textbox_font ( t, type );
         // Move into list view.
@@ -909,7 +1491,8 @@ static void update_callback ( textbox *t, unsigned int index, void *udata, TextB
         if ( state->tokens && config.show_match ) {
             ThemeHighlight th = { HL_BOLD | HL_UNDERLINE, { 0.0, 0.0, 0.0, 0.0 } };
             th = rofi_theme_get_highlight ( WIDGET ( t ), "highlight", th );
-            helper_token_match_get_pango_attr ( th, state->tokens, textbox_get_visible_text ( t ), list );
+            const GArray *ranges = rofi_view_get_highlight_ranges ( state, line, textbox_get_visible_text ( t ) );
+            helper_token_match_ranges_get_pango_attr ( th, ranges, list );
         }
         for ( GList *iter = g_list_first ( add_list ); iter != NULL; iter = g_list_next ( iter ) ) {
             pango_attr_list_insert ( list, (PangoAttribute *) ( iter->data ) );
@@ -921,7 +1504,7 @@ static void update_callback ( textbox *t, unsigned int index, void *udata, TextB
     }
     else {
         int fstate = 0;
-        mode_get_display_value ( state->sw, state->line_map[index], &fstate, NULL, FALSE );
+        mode_get_display_value ( state->sw, rofi_view_get_line ( state, index ), &fstate, NULL, FALSE );
         type |= fstate;
         textbox_font ( t, type );
     }
@@ -994,7 +1577,8 @@ static void rofi_view_paste ( RofiViewState *state, xcb_selection_notify_event_t
             textbox_insert ( state->text, state->text->cursor, text, dl );
             textbox_cursor ( state->text, state->text->cursor + g_utf8_strlen ( text, -1 ) );
             // Force a redraw and refiltering of the text.
-            state->refilter = TRUE;
+            state->refilter       = TRUE;
+            state->refilter_input = TRUE;
         }
         g_free ( text );
     }
@@ -1031,95 +1615,425 @@ static void rofi_view_mouse_navigation ( RofiViewState *state, xcb_button_press_
 static void _rofi_view_reload_row ( RofiViewState *state )
 {
     g_free ( state->line_map );
-    g_free ( state->distance );
-    state->num_lines = mode_get_num_entries ( state->sw );
-    state->line_map  = g_malloc0_n ( state->num_lines, sizeof ( unsigned int ) );
-    state->distance  = g_malloc0_n ( state->num_lines, sizeof ( int ) );
+    g_free ( state->sort_keys );
+    g_free ( state->signatures );
+    rofi_view_corpus_free ( state );
+    rofi_view_filter_reset ( state );
+    rofi_view_filter_cache_clear ( state );
+    rofi_view_highlight_cache_clear ( state );
+    state->num_lines       = mode_get_num_entries ( state->sw );
+    state->allocated_lines = state->num_lines;
+    state->line_map        = g_malloc0_n ( state->num_lines, sizeof ( unsigned int ) );
+    state->sort_keys       = g_malloc0_n ( state->num_lines, sizeof ( guint64 ) );
+    state->signatures      = g_malloc0_n ( state->num_lines, sizeof ( guint64 ) );
+    state->corpus          = g_malloc0_n ( state->num_lines, sizeof ( rofi_int_corpus_entry ) );
     listview_set_max_lines ( state->list_view, state->num_lines );
     rofi_view_reload_message_bar ( state );
 }
 
-static void rofi_view_refilter ( RofiViewState *state )
+/**
+ * @param state The view state.
+ *
+ * Entries were appended to the mode, the existing entries did not change.
+ * The arrays grow geometrically and keep their content, so the result of the previous
+ * filter stays valid and only the new entries have to be checked.
+ */
+static void _rofi_view_append_rows ( RofiViewState *state )
 {
-    TICK_N ( "Filter start" );
-    if ( state->reload ) {
+    unsigned int num_lines = mode_get_num_entries ( state->sw );
+    if ( num_lines < state->num_lines ) {
         _rofi_view_reload_row ( state );
-        state->reload = FALSE;
+        return;
     }
-    if ( state->tokens ) {
-        tokenize_free ( state->tokens );
-        state->tokens = NULL;
+    if ( num_lines > state->allocated_lines ) {
+        unsigned int size = MAX ( num_lines, state->allocated_lines * 2 );
+        unsigned int grow = size - state->allocated_lines;
+        state->line_map   = g_realloc ( state->line_map, size * sizeof ( unsigned int ) );
+        state->sort_keys  = g_realloc ( state->sort_keys, size * sizeof ( guint64 ) );
+        state->signatures = g_realloc ( state->signatures, size * sizeof ( guint64 ) );
+        state->corpus     = g_realloc ( state->corpus, size * sizeof ( rofi_int_corpus_entry ) );
+        memset ( &( state->signatures[state->allocated_lines] ), 0, grow * sizeof ( guint64 ) );
+        memset ( &( state->corpus[state->allocated_lines] ), 0, grow * sizeof ( rofi_int_corpus_entry ) );
+        state->allocated_lines = size;
+    }
+    state->num_lines = num_lines;
+    // Stored results do not include the new entries.
+    rofi_view_filter_cache_clear ( state );
+    listview_set_max_lines ( state->list_view, state->num_lines );
+    rofi_view_reload_message_bar ( state );
+}
+
+/**
+ * @param state The view state.
+ * @param pattern The preprocessed query.
+ *
+ * Check if the query extends the previous one, by appending to a token or adding a token.
+ * Every entry that matches the query then also matched the previous query (or was appended since).
+ * This does not hold for regex.
+ *
+ * @returns TRUE if only the previous matches need to be checked.
+ */
+static gboolean rofi_view_filter_is_refinement ( const RofiViewState *state, const char *pattern )
+{
+    if ( state->filter_text == NULL || config.matching_method == MM_REGEX ) {
+        return FALSE;
     }
-    if ( strlen ( state->text->text ) > 0 ) {
-        unsigned int j        = 0;
-        gchar        *pattern = mode_preprocess_input ( state->sw, state->text->text );
-        glong        plen     = pattern ? g_utf8_strlen ( pattern, -1 ) : 0;
-        state->tokens = tokenize ( pattern, config.case_sensitive );
-        /**
-         * On long lists it can be beneficial to parallelize.
-         * If number of threads is 1, no thread is spawn.
-         * If number of threads > 1 and there are enough (> 1000) items, spawn jobs for the thread pool.
-         * For large lists with 8 threads I see a factor three speedup of the whole function.
-         */
-        unsigned int nt = MAX ( 1, state->num_lines / 500 );
-        thread_state states[nt];
-        GCond        cond;
-        GMutex       mutex;
-        g_mutex_init ( &mutex );
-        g_cond_init ( &cond );
-        unsigned int count = nt;
-        unsigned int steps = ( state->num_lines + nt ) / nt;
-        for ( unsigned int i = 0; i < nt; i++ ) {
-            states[i].state    = state;
-            states[i].start    = i * steps;
-            states[i].stop     = MIN ( state->num_lines, ( i + 1 ) * steps );
-            states[i].count    = 0;
-            states[i].cond     = &cond;
-            states[i].mutex    = &mutex;
-            states[i].acount   = &count;
-            states[i].plen     = plen;
-            states[i].pattern  = pattern;
-            states[i].callback = filter_elements;
-            if ( i > 0 ) {
-                g_thread_pool_push ( tpool, &states[i], NULL );
-            }
+    if ( state->filter_matching_method != config.matching_method || state->filter_case_sensitive != config.case_sensitive ) {
+        return FALSE;
+    }
+    // Both the user input (combi selects the modes with it) and the pattern should be extended.
+    return g_str_has_prefix ( state->text->text, state->filter_text ) &&
+           g_str_has_prefix ( pattern ? pattern : "", state->filter_pattern );
+}
+
+/**
+ * @param state The view state.
+ * @param pattern The preprocessed query.
+ *
+ * Check if the previous filter ran the same query, on fewer entries. The entries
+ * since appended are then the only ones that need to be checked.
+ *
+ * @returns TRUE if the new matches can be added to the current result.
+ */
+static gboolean rofi_view_filter_is_append ( const RofiViewState *state, const char *pattern )
+{
+    if ( state->filter_text == NULL || state->filter_num_lines >= state->num_lines ) {
+        return FALSE;
+    }
+    if ( state->filter_matching_method != config.matching_method || state->filter_case_sensitive != config.case_sensitive ) {
+        return FALSE;
+    }
+    // The new sort keys are merged with the current ones.
+    if ( state->filter_sort != config.sort || state->filter_levenshtein_sort != config.levenshtein_sort ) {
+        return FALSE;
+    }
+    return g_strcmp0 ( state->text->text, state->filter_text ) == 0 &&
+           g_strcmp0 ( pattern ? pattern : "", state->filter_pattern ) == 0;
+}
+
+/**
+ * @param state The view state.
+ * @param candidates The candidates from the mode, or NULL.
+ * @param length The number of candidates. [in][out]
+ *
+ * Restrict the candidates to the entries appended since the previous filter.
+ *
+ * @returns the new candidates, sorted on index.
+ */
+static unsigned int *rofi_view_filter_appended ( const RofiViewState *state, unsigned int *candidates, unsigned int *length )
+{
+    unsigned int first = state->filter_num_lines;
+    if ( candidates == NULL ) {
+        *length    = state->num_lines - first;
+        candidates = g_malloc_n ( MAX ( 1, *length ), sizeof ( unsigned int ) );
+        for ( unsigned int i = 0; i < *length; i++ ) {
+            candidates[i] = first + i;
         }
-        // Run one in this thread.
-        rofi_view_call_thread ( &states[0], NULL );
-        // No need to do this with only one thread.
-        if ( nt > 1 ) {
-            g_mutex_lock ( &mutex );
-            while ( count > 0 ) {
-                g_cond_wait ( &cond, &mutex );
+        return candidates;
+    }
+    unsigned int m = 0;
+    for ( unsigned int i = 0; i < *length; i++ ) {
+        if ( candidates[i] >= first ) {
+            candidates[m++] = candidates[i];
+        }
+    }
+    *length = m;
+    return candidates;
+}
+
+/**
+ * @param state The view state.
+ * @param candidates The candidates from the mode, or NULL.
+ * @param length The number of candidates. [in][out]
+ *
+ * Restrict the candidates to the entries that matched the previous query,
+ * and the entries appended since (these were not checked).
+ *
+ * @returns the new candidates, sorted on index.
+ */
+static unsigned int *rofi_view_filter_narrow ( const RofiViewState *state, unsigned int *candidates, unsigned int *length )
+{
+    unsigned int n     = state->filtered_lines;
+    unsigned int first = state->filter_num_lines;
+    unsigned int *prev = g_malloc_n ( MAX ( 1, n + ( state->num_lines - first ) ), sizeof ( unsigned int ) );
+    memcpy ( prev, state->line_map, n * sizeof ( unsigned int ) );
+    // Keep the entries in the same order as a full filter would check them.
+    g_qsort_with_data ( prev, n, sizeof ( unsigned int ), index_sort, NULL );
+    // The appended entries come after all previous matches.
+    for ( unsigned int i = first; i < state->num_lines; i++ ) {
+        prev[n++] = i;
+    }
+    if ( candidates != NULL ) {
+        unsigned int m = 0;
+        for ( unsigned int i = 0, k = 0; i < n && k < *length; ) {
+            if ( prev[i] < candidates[k] ) {
+                i++;
+            }
+            else if ( prev[i] > candidates[k] ) {
+                k++;
+            }
+            else {
+                prev[m++] = prev[i++];
+                k++;
             }
-            g_mutex_unlock ( &mutex );
         }
-        g_cond_clear ( &cond );
-        g_mutex_clear ( &mutex );
-        for ( unsigned int i = 0; i < nt; i++ ) {
-            if ( j != states[i].start ) {
-                memmove ( &( state->line_map[j] ), &( state->line_map[states[i].start] ), sizeof ( unsigned int ) * ( states[i].count ) );
+        n = m;
+        g_free ( candidates );
+    }
+    *length = n;
+    return prev;
+}
+
+/**
+ * The matches of one chunk of a filter run.
+ */
+typedef struct
+{
+    /** The worker that checked the chunk. */
+    unsigned int worker;
+    /** Where the matches start in the output of the worker. */
+    unsigned int offset;
+    /** Number of matches. */
+    unsigned int count;
+    /** Where the matches start in the merged result. */
+    unsigned int dest;
+} FilterChunk;
+
+/**
+ * The matches found by one filter worker, in the order it checked its chunks.
+ */
+typedef struct
+{
+    unsigned int *line_map;
+    /** Their sort keys, NULL when not sorting. */
+    guint64      *sort_keys;
+    unsigned int length;
+    /** Allocated size of line_map and sort_keys. */
+    unsigned int size;
+} FilterOutput;
+
+/**
+ * A filter run, either blocking or in the background on the thread pool.
+ */
+typedef struct _FilterJob
+{
+    RofiViewState         *state;
+    /** Value of state->filter_generation when started. */
+    gint                  generation;
+    /** The user input and the preprocessed query. */
+    char                  *text;
+    char                  *pattern;
+    rofi_int_corpus_entry pcorpus;
+    unsigned int          *candidates;
+    /** If the matches are sorted. */
+    gboolean              sort;
+    /** If only appended entries are checked, the matches are added to the current result. */
+    gboolean              append;
+    /** The matches, merged from the outputs of the workers (and sorted) when all finished. */
+    unsigned int          *line_map;
+    /** Their sort keys, NULL when not sorting. */
+    guint64               *sort_keys;
+    unsigned int          length;
+    /** Number of matches in final order. */
+    unsigned int          sorted;
+    /** The workers and their matches. */
+    thread_state          *states;
+    FilterOutput          *outputs;
+    unsigned int          nt;
+    /** The chunks of FILTER_CHUNK entries. */
+    FilterChunk           *chunks;
+    unsigned int          nchunks;
+    /** The next chunk to hand out to a worker. */
+    volatile gint         next_chunk;
+    /** Number of workers still running. */
+    volatile gint         count;
+    /** Set (with mutex held) when all workers finished. */
+    gboolean              finished;
+    GMutex                mutex;
+    GCond                 cond;
+    /** The idle source publishing the result, 0 if none. */
+    guint                 source;
+    /** When the job was started (us). */
+    gint64                start_time;
+} FilterJob;
+
+static void rofi_view_filter_job_free ( FilterJob *job )
+{
+    g_mutex_clear ( &( job->mutex ) );
+    g_cond_clear ( &( job->cond ) );
+    helper_corpus_entry_clear ( &( job->pcorpus ) );
+    g_free ( job->candidates );
+    g_free ( job->line_map );
+    g_free ( job->sort_keys );
+    for ( unsigned int i = 0; i < job->nt; i++ ) {
+        g_free ( job->outputs[i].line_map );
+        g_free ( job->outputs[i].sort_keys );
+    }
+    g_free ( job->outputs );
+    g_free ( job->chunks );
+    g_free ( job->states );
+    g_free ( job->text );
+    g_free ( job->pattern );
+    g_free ( job );
+}
+
+/**
+ * @param t The worker.
+ * @param user_data Unused.
+ *
+ * Check chunks of the job until all are handed out, so workers that get cheap entries
+ * take over the work of the ones that get expensive entries.
+ */
+static void rofi_view_filter_job_run ( thread_state *t, gpointer user_data )
+{
+    FilterJob    *job    = (FilterJob *) t->data;
+    unsigned int worker  = t - job->states;
+    FilterOutput *output = &( job->outputs[worker] );
+    while ( g_atomic_int_get ( &( job->state->filter_generation ) ) == t->generation ) {
+        unsigned int chunk = (unsigned int) g_atomic_int_add ( &( job->next_chunk ), 1 );
+        if ( chunk >= job->nchunks ) {
+            break;
+        }
+        // Matches go to a buffer of this worker, so workers do not write to the same cache lines.
+        if ( output->length + FILTER_CHUNK > output->size ) {
+            output->size     = MAX ( output->size * 2, 8 * FILTER_CHUNK );
+            output->line_map = g_realloc_n ( output->line_map, output->size, sizeof ( unsigned int ) );
+            if ( job->sort ) {
+                output->sort_keys = g_realloc_n ( output->sort_keys, output->size, sizeof ( guint64 ) );
             }
-            j += states[i].count;
         }
-        if ( config.sort ) {
-            g_qsort_with_data ( state->line_map, j, sizeof ( int ), lev_sort, state->distance );
+        t->start     = chunk * FILTER_CHUNK;
+        t->stop      = MIN ( job->length, t->start + FILTER_CHUNK );
+        t->count     = 0;
+        t->line_map  = &( output->line_map[output->length] );
+        t->sort_keys = job->sort ? &( output->sort_keys[output->length] ) : NULL;
+        filter_elements ( t, user_data );
+        job->chunks[chunk].worker = worker;
+        job->chunks[chunk].offset = output->length;
+        job->chunks[chunk].count  = t->count;
+        output->length           += t->count;
+    }
+}
+
+/**
+ * @param t The merge worker, handling chunks start to stop.
+ * @param user_data Unused.
+ *
+ * Copy the matches of the chunks to their place in the merged result.
+ */
+static void rofi_view_filter_job_merge_chunks ( thread_state *t, G_GNUC_UNUSED gpointer user_data )
+{
+    FilterJob *job = (FilterJob *) t->data;
+    for ( unsigned int i = t->start; i < t->stop; i++ ) {
+        const FilterChunk  *chunk  = &( job->chunks[i] );
+        const FilterOutput *output = &( job->outputs[chunk->worker] );
+        if ( chunk->count == 0 ) {
+            continue;
         }
+        if ( job->sort_keys != NULL ) {
+            // The line map is rebuilt from the keys once they are ordered.
+            memcpy ( &( job->sort_keys[chunk->dest] ), &( output->sort_keys[chunk->offset] ), chunk->count * sizeof ( guint64 ) );
+        }
+        else {
+            memcpy ( &( job->line_map[chunk->dest] ), &( output->line_map[chunk->offset] ), chunk->count * sizeof ( unsigned int ) );
+        }
+    }
+}
 
-        // Cleanup + bookkeeping.
-        state->filtered_lines = j;
-        g_free ( pattern );
+/**
+ * @param t The worker, handling matches start to stop.
+ * @param user_data Unused.
+ *
+ * Fill the line map from the (ordered) sort keys.
+ */
+static void rofi_view_filter_job_index_keys ( thread_state *t, G_GNUC_UNUSED gpointer user_data )
+{
+    FilterJob *job = (FilterJob *) t->data;
+    for ( unsigned int i = t->start; i < t->stop; i++ ) {
+        job->line_map[i] = SORT_KEY_INDEX ( job->sort_keys[i] );
     }
-    else{
-        for ( unsigned int i = 0; i < state->num_lines; i++ ) {
-            state->line_map[i] = i;
+}
+
+/**
+ * @param t The worker finishing last.
+ *
+ * Merge the results of the workers and sort the first SORT_CHUNK of them, the rest is sorted when shown.
+ * An exclusive scan over the chunks gives the place of each chunk in the result, then the chunks are copied
+ * there in parallel. This is run on the worker so sorting does not block the main loop.
+ */
+static void rofi_view_filter_job_compact ( thread_state *t )
+{
+    FilterJob    *job = (FilterJob *) t->data;
+    unsigned int j    = 0;
+    if ( g_atomic_int_get ( &( job->state->filter_generation ) ) != job->generation ) {
+        return;
+    }
+    for ( unsigned int i = 0; i < job->nchunks; i++ ) {
+        job->chunks[i].dest = j;
+        j                  += job->chunks[i].count;
+    }
+    job->length   = j;
+    job->sorted   = j;
+    job->line_map = g_malloc_n ( MAX ( 1, j ), sizeof ( unsigned int ) );
+    if ( job->sort ) {
+        job->sort_keys = g_malloc_n ( MAX ( 1, j ), sizeof ( guint64 ) );
+    }
+    unsigned int nt      = MAX ( 1, MIN ( config.threads, j / FILTER_MERGE_CHUNK ) );
+    thread_state *states = g_malloc0_n ( nt, sizeof ( thread_state ) );
+    unsigned int steps   = ( job->nchunks + nt - 1 ) / nt;
+    for ( unsigned int i = 0; i < nt; i++ ) {
+        states[i].start    = MIN ( job->nchunks, i * steps );
+        states[i].stop     = MIN ( job->nchunks, ( i + 1 ) * steps );
+        states[i].callback = rofi_view_filter_job_merge_chunks;
+        states[i].data     = job;
+    }
+    rofi_view_run_threads ( states, nt );
+    if ( job->sort ) {
+        job->sorted = MIN ( j, SORT_CHUNK );
+        sort_keys_select ( job->sort_keys, j, job->sorted );
+        steps = ( j + nt - 1 ) / nt;
+        for ( unsigned int i = 0; i < nt; i++ ) {
+            states[i].start    = MIN ( j, i * steps );
+            states[i].stop     = MIN ( j, ( i + 1 ) * steps );
+            states[i].callback = rofi_view_filter_job_index_keys;
         }
-        state->filtered_lines = state->num_lines;
+        rofi_view_run_threads ( states, nt );
+    }
+    g_free ( states );
+}
+
+static gboolean rofi_view_filter_job_done ( gpointer data );
+static void rofi_view_refilter ( RofiViewState *state, gboolean async );
+static void rofi_view_filter_job_finalize ( thread_state *t )
+{
+    FilterJob *job = (FilterJob *) t->data;
+    rofi_view_filter_job_compact ( t );
+    job->source = g_idle_add ( rofi_view_filter_job_done, job );
+}
+
+/**
+ * @param state The view state.
+ * @param text The user input that was filtered.
+ * @param pattern The preprocessed query.
+ *
+ * Update the filter bookkeeping and the list after the matches are placed in state->line_map.
+ */
+static void rofi_view_refilter_done ( RofiViewState *state, const char *text, const char *pattern )
+{
+    rofi_view_filter_reset ( state );
+    state->filter_num_lines = state->num_lines;
+    if ( text != NULL ) {
+        state->filter_text            = g_strdup ( text );
+        state->filter_pattern         = g_strdup ( pattern ? pattern : "" );
+        state->filter_matching_method  = config.matching_method;
+        state->filter_case_sensitive   = config.case_sensitive;
+        state->filter_sort             = config.sort;
+        state->filter_levenshtein_sort = config.levenshtein_sort;
     }
     listview_set_num_elements ( state->list_view, state->filtered_lines );
 
     if ( config.auto_select == TRUE && state->filtered_lines == 1 && state->num_lines > 1 ) {
-        ( state->selected_line ) = state->line_map[listview_get_selected ( state->list_view  )];
+        ( state->selected_line ) = rofi_view_get_line ( state, listview_get_selected ( state->list_view ) );
         state->retv              = MENU_OK;
         state->quit              = TRUE;
     }
@@ -1131,9 +2045,332 @@ static void rofi_view_refilter ( RofiViewState *state )
         rofi_view_window_update_size ( state );
         g_debug ( "Resize based on re-filter" );
     }
-    state->refilter = FALSE;
+}
+
+/**
+ * @param state The view state.
+ * @param job The finished job.
+ *
+ * Publish the result of job.
+ */
+static void rofi_view_filter_job_publish ( RofiViewState *state, FilterJob *job )
+{
+    unsigned int offset = job->append ? state->filtered_lines : 0;
+    memcpy ( &( state->line_map[offset] ), job->line_map, job->length * sizeof ( unsigned int ) );
+    if ( job->sort_keys != NULL ) {
+        memcpy ( &( state->sort_keys[offset] ), job->sort_keys, job->length * sizeof ( guint64 ) );
+    }
+    state->filtered_lines = offset + job->length;
+    if ( !job->append ) {
+        state->sorted_lines = job->sorted;
+    }
+    else if ( !job->sort ) {
+        state->sorted_lines = state->filtered_lines;
+    }
+    else if ( job->length > 0 ) {
+        // New matches can go anywhere, order all again when needed.
+        state->sorted_lines = 0;
+    }
+    state->filter_time    = ( state->filter_time + g_get_monotonic_time () - job->start_time ) / 2;
+    rofi_view_filter_cache_store ( state, job->text );
+    rofi_view_refilter_done ( state, job->text, job->pattern );
     TICK_N ( "Filter done" );
 }
+
+/**
+ * @param data The finished FilterJob.
+ *
+ * Called from the main loop when a background filter finished (or stopped after being cancelled).
+ *
+ * @returns G_SOURCE_REMOVE
+ */
+static gboolean rofi_view_filter_job_done ( gpointer data )
+{
+    FilterJob     *job   = (FilterJob *) data;
+    RofiViewState *state = job->state;
+    // Wait for the worker to release the job.
+    g_mutex_lock ( &( job->mutex ) );
+    job->source = 0;
+    g_mutex_unlock ( &( job->mutex ) );
+    state->filter_job = NULL;
+    if ( g_atomic_int_get ( &( state->filter_generation ) ) == job->generation ) {
+        rofi_view_filter_job_publish ( state, job );
+        rofi_view_queue_redraw ();
+    }
+    rofi_view_filter_job_free ( job );
+    if ( state->refilter ) {
+        // Input changed while filtering, start over.
+        rofi_view_refilter ( state, TRUE );
+        rofi_view_queue_redraw ();
+    }
+    return G_SOURCE_REMOVE;
+}
+
+/**
+ * @param state The view state.
+ * @param cancel If the running filter should be stopped.
+ *
+ * Wait for the filter running in the background (if any).
+ * When it was not cancelled, its result is published.
+ */
+static void rofi_view_filter_job_wait ( RofiViewState *state, gboolean cancel )
+{
+    FilterJob *job = state->filter_job;
+    if ( job == NULL ) {
+        return;
+    }
+    if ( cancel ) {
+        g_atomic_int_inc ( &( state->filter_generation ) );
+    }
+    g_mutex_lock ( &( job->mutex ) );
+    while ( !job->finished ) {
+        g_cond_wait ( &( job->cond ), &( job->mutex ) );
+    }
+    g_mutex_unlock ( &( job->mutex ) );
+    // The idle is not dispatched yet, we run on the main loop.
+    if ( job->source > 0 ) {
+        g_source_remove ( job->source );
+        job->source = 0;
+    }
+    state->filter_job = NULL;
+    if ( g_atomic_int_get ( &( state->filter_generation ) ) == job->generation ) {
+        rofi_view_filter_job_publish ( state, job );
+    }
+    else {
+        state->refilter = TRUE;
+    }
+    rofi_view_filter_job_free ( job );
+}
+
+/**
+ * @param state The view state.
+ * @param text The user input.
+ * @param pattern The preprocessed query (ownership is taken).
+ * @param async If the filter may run in the background.
+ * @param append If only the entries appended since the previous filter (of the same query) are checked.
+ *
+ * Check the entries against state->tokens.
+ * Large lists are split over the thread pool, when async the result is published from the main loop when done.
+ */
+static void rofi_view_filter_start ( RofiViewState *state, const char *text, char *pattern, gboolean async, gboolean append )
+{
+    FilterJob *job = g_malloc0 ( sizeof ( FilterJob ) );
+    job->state      = state;
+    job->generation = g_atomic_int_add ( &( state->filter_generation ), 1 ) + 1;
+    job->text       = g_strdup ( text );
+    job->pattern    = pattern;
+    job->start_time = g_get_monotonic_time ();
+    helper_corpus_entry_init ( &( job->pcorpus ), pattern ? pattern : "", config.case_sensitive );
+    guint64 signature = helper_tokens_signature ( state->tokens );
+    job->length     = state->num_lines;
+    job->candidates = mode_get_candidates ( state->sw, state->tokens, &( job->length ) );
+    if ( append ) {
+        job->candidates = rofi_view_filter_appended ( state, job->candidates, &( job->length ) );
+    }
+    else if ( rofi_view_filter_is_refinement ( state, pattern ) ) {
+        job->candidates = rofi_view_filter_narrow ( state, job->candidates, &( job->length ) );
+    }
+    job->sort   = config.sort;
+    job->append = append;
+    /**
+     * On long lists it can be beneficial to parallelize.
+     * The entries are split in chunks of FILTER_CHUNK, one worker per thread (at most) takes chunks until
+     * all are done. Each worker stores its matches in its own buffer, so no locking is needed.
+     */
+    job->nchunks = ( job->length + FILTER_CHUNK - 1 ) / FILTER_CHUNK;
+    job->chunks  = g_malloc0_n ( MAX ( 1, job->nchunks ), sizeof ( FilterChunk ) );
+    job->nt      = MAX ( 1, MIN ( config.threads, job->nchunks ) );
+    job->states  = g_malloc0_n ( job->nt, sizeof ( thread_state ) );
+    job->outputs = g_malloc0_n ( job->nt, sizeof ( FilterOutput ) );
+    job->count   = job->nt;
+    g_mutex_init ( &( job->mutex ) );
+    g_cond_init ( &( job->cond ) );
+    // Small lists are not worth the round trip through the main loop.
+    async = async && job->nchunks > 1;
+    for ( unsigned int i = 0; i < job->nt; i++ ) {
+        thread_state *t = &( job->states[i] );
+        t->state         = state;
+        t->cond          = &( job->cond );
+        t->mutex         = &( job->mutex );
+        t->acount        = &( job->count );
+        t->finished      = &( job->finished );
+        t->pattern       = &( job->pcorpus );
+        t->signature     = signature;
+        t->candidates    = job->candidates;
+        t->generation    = job->generation;
+        t->callback      = rofi_view_filter_job_run;
+        t->finalize      = async ? rofi_view_filter_job_finalize : rofi_view_filter_job_compact;
+        t->data          = job;
+    }
+    state->filter_job = job;
+    for ( unsigned int i = async ? 0 : 1; i < job->nt; i++ ) {
+        g_thread_pool_push ( tpool, &( job->states[i] ), NULL );
+    }
+    if ( !async ) {
+        // Run one in this thread and wait for the others.
+        rofi_view_call_thread ( &( job->states[0] ), NULL );
+        rofi_view_filter_job_wait ( state, FALSE );
+    }
+}
+
+/**
+ * @param state The view state.
+ * @param pattern The preprocessed query, NULL if none.
+ *
+ * Compile the tokens for pattern. Compiling (regex) tokens is expensive, so this is skipped when the
+ * tokens were compiled from the same query and settings, f.e. when entries are added while reading input.
+ */
+static void rofi_view_set_tokens ( RofiViewState *state, const char *pattern )
+{
+    if ( g_strcmp0 ( state->tokens_pattern, pattern ) == 0 &&
+         ( pattern == NULL || ( state->tokens_matching_method == (int) config.matching_method &&
+                                state->tokens_case_sensitive == (int) config.case_sensitive ) ) ) {
+        return;
+    }
+    if ( state->tokens ) {
+        tokenize_free ( state->tokens );
+        state->tokens = NULL;
+    }
+    g_free ( state->tokens_pattern );
+    state->tokens_pattern         = g_strdup ( pattern );
+    state->tokens_matching_method = config.matching_method;
+    state->tokens_case_sensitive  = config.case_sensitive;
+    if ( pattern != NULL ) {
+        state->tokens = tokenize ( pattern, config.case_sensitive );
+    }
+    rofi_view_highlight_cache_clear ( state );
+}
+
+/**
+ * @param state The view state.
+ * @param async If the filter may run in the background.
+ *
+ * Filter the entries on the current input.
+ * When a background filter is still running, it is cancelled and this is retried when it stopped.
+ */
+static void rofi_view_refilter ( RofiViewState *state, gboolean async )
+{
+    if ( state->filter_job != NULL ) {
+        if ( async ) {
+            // Workers stop at the next chunk, rofi_view_filter_job_done() restarts.
+            g_atomic_int_inc ( &( state->filter_generation ) );
+            state->refilter = TRUE;
+            return;
+        }
+        rofi_view_filter_job_wait ( state, TRUE );
+    }
+    TICK_N ( "Filter start" );
+    // Auto select needs the result before the next event is handled.
+    async = async && !config.auto_select;
+    state->refilter = FALSE;
+    if ( state->reload ) {
+        _rofi_view_reload_row ( state );
+        state->reload        = FALSE;
+        state->reload_append = FALSE;
+    }
+    else if ( state->reload_append ) {
+        _rofi_view_append_rows ( state );
+        state->reload_append = FALSE;
+    }
+    if ( state->corpus_case_sensitive != config.case_sensitive ) {
+        // The folded forms are no longer valid.
+        rofi_view_corpus_free ( state );
+        state->corpus                = g_malloc0_n ( state->allocated_lines, sizeof ( rofi_int_corpus_entry ) );
+        state->corpus_case_sensitive = config.case_sensitive;
+    }
+    if ( strlen ( state->text->text ) > 0 ) {
+        gchar *pattern = mode_preprocess_input ( state->sw, state->text->text );
+        rofi_view_set_tokens ( state, pattern );
+        if ( rofi_view_filter_cache_restore ( state ) ) {
+            rofi_view_refilter_done ( state, state->text->text, pattern );
+            g_free ( pattern );
+            TICK_N ( "Filter done" );
+        }
+        else {
+            rofi_view_filter_start ( state, state->text->text, pattern, async, rofi_view_filter_is_append ( state, pattern ) );
+        }
+    }
+    else{
+        rofi_view_set_tokens ( state, NULL );
+        for ( unsigned int i = 0; i < state->num_lines; i++ ) {
+            state->line_map[i] = i;
+        }
+        state->filtered_lines = state->num_lines;
+        state->sorted_lines   = state->num_lines;
+        rofi_view_refilter_done ( state, NULL, NULL );
+        TICK_N ( "Filter done" );
+    }
+}
+
+/**
+ * @param state The view state.
+ *
+ * Make sure the list matches the current input, used before acting on the selected entry.
+ */
+static void rofi_view_refilter_flush ( RofiViewState *state )
+{
+    if ( state->refilter_timeout > 0 ) {
+        g_source_remove ( state->refilter_timeout );
+        state->refilter_timeout = 0;
+    }
+    rofi_view_filter_job_wait ( state, FALSE );
+    if ( state->refilter ) {
+        rofi_view_refilter ( state, FALSE );
+    }
+}
+
+static gboolean rofi_view_refilter_timeout ( gpointer data )
+{
+    RofiViewState *state = (RofiViewState *) data;
+    state->refilter_timeout = 0;
+    if ( state->refilter ) {
+        rofi_view_refilter ( state, TRUE );
+        rofi_view_queue_redraw ();
+    }
+    return G_SOURCE_REMOVE;
+}
+
+/**
+ * @param state The view state.
+ *
+ * Filter on the changed input.
+ * Above config.lazy_filter_limit entries, and when the user types faster than a filter takes,
+ * the filter is deferred so a burst of key presses is handled in one pass.
+ * Only input changes count towards the typing rate, other requests filter directly.
+ */
+static void rofi_view_refilter_schedule ( RofiViewState *state )
+{
+    if ( !state->refilter_input ) {
+        // A pending deferred filter picks this up.
+        if ( state->refilter_timeout == 0 ) {
+            rofi_view_refilter ( state, TRUE );
+        }
+        return;
+    }
+    state->refilter_input = FALSE;
+    gint64 now = g_get_monotonic_time ();
+    if ( state->refilter_requested > 0 ) {
+        gint64 interval = MIN ( now - state->refilter_requested, LAZY_FILTER_MAX_INTERVAL );
+        state->refilter_interval = ( state->refilter_interval + interval ) / 2;
+    }
+    else {
+        state->refilter_interval = LAZY_FILTER_MAX_INTERVAL;
+    }
+    state->refilter_requested = now;
+    if ( state->refilter_timeout > 0 ) {
+        // Already pending, it picks up the new input.
+        return;
+    }
+    if ( config.lazy_filter_limit > 0 && state->num_lines > config.lazy_filter_limit &&
+         state->refilter_interval < state->filter_time ) {
+        // Wait a bit longer than the typical pause between key presses.
+        gint64 delay = MIN ( state->refilter_interval * 3 / 2, LAZY_FILTER_MAX_DELAY );
+        state->refilter_timeout = g_timeout_add ( delay / 1000, rofi_view_refilter_timeout, state );
+        return;
+    }
+    rofi_view_refilter ( state, TRUE );
+}
+
 /**
  * @param state The Menu Handle
  *
@@ -1143,6 +2380,8 @@ void process_result ( RofiViewState *state );
 void rofi_view_finalize ( RofiViewState *state )
 {
     if ( state && state->finalize != NULL ) {
+        // The mode acts on the result, it can free its entries: stop the workers still matching them.
+        rofi_view_filter_job_wait ( state, TRUE );
         state->finalize ( state );
     }
 }
@@ -1196,9 +2435,10 @@ gboolean rofi_view_trigger_action ( RofiViewState *state, KeyBindingAction actio
     // Special delete entry command.
     case DELETE_ENTRY:
     {
+        rofi_view_refilter_flush ( state );
         unsigned int selected = listview_get_selected ( state->list_view );
         if ( selected < state->filtered_lines ) {
-            ( state->selected_line ) = state->line_map[selected];
+            ( state->selected_line ) = rofi_view_get_line ( state, selected );
             state->retv              = MENU_ENTRY_DELETE;
             state->quit              = TRUE;
         }
@@ -1218,9 +2458,10 @@ gboolean rofi_view_trigger_action ( RofiViewState *state, KeyBindingAction actio
     case SELECT_ELEMENT_9:
     case SELECT_ELEMENT_10:
     {
+        rofi_view_refilter_flush ( state );
         unsigned int index = action - SELECT_ELEMENT_1;
         if ( index < state->filtered_lines ) {
-            state->selected_line = state->line_map[index];
+            state->selected_line = rofi_view_get_line ( state, index );
             state->retv          = MENU_OK;
             state->quit          = TRUE;
         }
@@ -1246,10 +2487,11 @@ gboolean rofi_view_trigger_action ( RofiViewState *state, KeyBindingAction actio
     case CUSTOM_18:
     case CUSTOM_19:
     {
+        rofi_view_refilter_flush ( state );
         state->selected_line = UINT32_MAX;
         unsigned int selected = listview_get_selected ( state->list_view );
         if ( selected < state->filtered_lines ) {
-            ( state->selected_line ) = state->line_map[selected];
+            ( state->selected_line ) = rofi_view_get_line ( state, selected );
         }
         state->retv = MENU_QUICK_SWITCH | ( ( action - CUSTOM_1 ) & MENU_LOWER_MASK );
         state->quit = TRUE;
@@ -1308,7 +2550,8 @@ gboolean rofi_view_trigger_action ( RofiViewState *state, KeyBindingAction actio
         int rc = textbox_keybinding ( state->text, action );
         if ( rc == 1 ) {
             // Entry changed.
-            state->refilter = TRUE;
+            state->refilter       = TRUE;
+            state->refilter_input = TRUE;
         }
         else if ( rc == 2 ) {
             // Movement.
@@ -1317,10 +2560,11 @@ gboolean rofi_view_trigger_action ( RofiViewState *state, KeyBindingAction actio
     }
     case ACCEPT_ALT:
     {
+        rofi_view_refilter_flush ( state );
         unsigned int selected = listview_get_selected ( state->list_view );
         state->selected_line = UINT32_MAX;
         if ( selected < state->filtered_lines ) {
-            ( state->selected_line ) = state->line_map[selected];
+            ( state->selected_line ) = rofi_view_get_line ( state, selected );
             state->retv              = MENU_OK;
         }
         else {
@@ -1341,10 +2585,11 @@ gboolean rofi_view_trigger_action ( RofiViewState *state, KeyBindingAction actio
     case ACCEPT_ENTRY:
     {
         // If a valid item is selected, return that..
+        rofi_view_refilter_flush ( state );
         unsigned int selected = listview_get_selected ( state->list_view );
         state->selected_line = UINT32_MAX;
         if ( selected < state->filtered_lines ) {
-            ( state->selected_line ) = state->line_map[selected];
+            ( state->selected_line ) = rofi_view_get_line ( state, selected );
             state->retv              = MENU_OK;
         }
         else {
@@ -1411,7 +2656,8 @@ static void rofi_view_handle_keypress ( RofiViewState *state, xkb_stuff *xkb, xc
     }
 
     if ( ( len > 0 ) && ( textbox_append_char ( state->text, pad, len ) ) ) {
-        state->refilter = TRUE;
+        state->refilter       = TRUE;
+        state->refilter_input = TRUE;
         return;
     }
 }
@@ -1511,7 +2757,7 @@ void rofi_view_itterrate ( RofiViewState *state, xcb_generic_event_t *event, xkb
     }
     // Update if requested.
     if ( state->refilter ) {
-        rofi_view_refilter ( state );
+        rofi_view_refilter_schedule ( state );
     }
     rofi_view_update ( state, TRUE );
 
@@ -1555,7 +2801,7 @@ static void rofi_view_listview_mouse_activated_cb ( listview *lv, xcb_button_pre
     if ( control ) {
         state->retv |= MENU_CUSTOM_ACTION;
     }
-    ( state->selected_line ) = state->line_map[listview_get_selected ( lv )];
+    ( state->selected_line ) = rofi_view_get_line ( state, listview_get_selected ( lv ) );
     // Quit
     state->quit        = TRUE;
     state->skip_absorb = TRUE;
@@ -1572,7 +2818,6 @@ RofiViewState *rofi_view_create ( Mode *sw,
     state->sw            = sw;
     state->selected_line = UINT32_MAX;
     state->retv          = MENU_CANCEL;
-    state->distance      = NULL;
     state->quit          = FALSE;
     state->skip_absorb   = FALSE;
     //We want to filter on the first run.
@@ -1653,8 +2898,12 @@ RofiViewState *rofi_view_create ( Mode *sw,
     box_add ( state->main_box, WIDGET ( state->list_view ), TRUE, 3 );
 
     // filtered list
-    state->line_map = g_malloc0_n ( state->num_lines, sizeof ( unsigned int ) );
-    state->distance = (int *) g_malloc0_n ( state->num_lines, sizeof ( int ) );
+    state->allocated_lines       = state->num_lines;
+    state->line_map              = g_malloc0_n ( state->num_lines, sizeof ( unsigned int ) );
+    state->sort_keys             = g_malloc0_n ( state->num_lines, sizeof ( guint64 ) );
+    state->signatures            = g_malloc0_n ( state->num_lines, sizeof ( guint64 ) );
+    state->corpus                = g_malloc0_n ( state->num_lines, sizeof ( rofi_int_corpus_entry ) );
+    state->corpus_case_sensitive = config.case_sensitive;
 
     rofi_view_calculate_window_width ( state );
     // Need to resize otherwise calculated desired height is wrong.
@@ -1668,7 +2917,7 @@ RofiViewState *rofi_view_create ( Mode *sw,
     rofi_view_calculate_window_position ( state );
 
     state->quit = FALSE;
-    rofi_view_refilter ( state );
+    rofi_view_refilter ( state, FALSE );
     rofi_view_update ( state, TRUE );
     xcb_map_window ( xcb->connection, CacheState.main_window );
     widget_queue_redraw ( WIDGET ( state->main_window ) );
@@ -1845,6 +3094,8 @@ void rofi_view_clear_input ( RofiViewState *state )
 
 void rofi_view_switch_mode ( RofiViewState *state, Mode *mode )
 {
+    // Workers still use the entries of the old mode.
+    rofi_view_filter_job_wait ( state, TRUE );
     state->sw = mode;
     // Update prompt;
     if ( state->prompt ) {
@@ -1859,7 +3110,7 @@ void rofi_view_switch_mode ( RofiViewState *state, Mode *mode )
     rofi_view_restart ( state );
     state->reload   = TRUE;
     state->refilter = TRUE;
-    rofi_view_refilter ( state );
+    rofi_view_refilter ( state, FALSE );
     rofi_view_update ( state, TRUE );
 }
 
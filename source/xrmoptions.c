@@ -162,6 +162,10 @@ static XrmOption xrmOptions[] = {
       "DPI", CONFIG_DEFAULT },
     { xrm_Number,  "threads",           { .num  = &config.threads               }, NULL,
       "Threads to use for string matching", CONFIG_DEFAULT },
+    { xrm_Number,  "filter-cache-size", { .num  = &config.filter_cache_size     }, NULL,
+      "Memory (KiB) used to cache filter results, 0 to disable", CONFIG_DEFAULT },
+    { xrm_Number,  "lazy-filter-limit", { .num  = &config.lazy_filter_limit     }, NULL,
+      "Defer filtering while typing on lists longer than this, 0 to disable", CONFIG_DEFAULT },
     { xrm_Number,  "scroll-method",     { .num  = &config.scroll_method         }, NULL,
       "Scrolling method. (0: Page, 1: Centered)", CONFIG_DEFAULT },
     { xrm_String,  "window-format",     { .str  = &config.window_format         }, NULL,
@@ -26,6 +26,7 @@
  */
 
 #include <assert.h>
+#include <limits.h>
 #include <locale.h>
 #include <glib.h>
 #include <stdio.h>
@@ -72,6 +73,75 @@ xcb_ewmh_connection_t xcb_ewmh;
 int                   xcb_screen_nbr;
 #include <x11-helper.h>
 
+/**
+ * The fuzzy scorer as it was before it worked on decoded strings, used as reference.
+ */
+static int reference_fuzzy_evaluate ( const char *pattern, glong plen, const char *str, glong slen )
+{
+    const int min_score = INT_MIN / 2;
+    if ( slen > 256 ) {
+        return -min_score;
+    }
+    glong       pi, si;
+    gboolean    pfirst = TRUE;
+    gboolean    pstart = TRUE;
+    int         *score = g_malloc_n ( slen, sizeof ( int ) );
+    int         *dp    = g_malloc_n ( slen, sizeof ( int ) );
+    int         uleft  = 0, ulefts = 0, left, lefts;
+    const gchar *pit   = pattern, *sit;
+    int         prev   = 3;
+    for ( si = 0, sit = str; si < slen; si++, sit = g_utf8_next_char ( sit ) ) {
+        gunichar c   = g_utf8_get_char ( sit );
+        // 0: lower, 1: upper, 2: digit, 3: non word.
+        int      cur = g_unichar_islower ( c ) ? 0 : g_unichar_isupper ( c ) ? 1 : g_unichar_isdigit ( c ) ? 2 : 3;
+        if ( prev == 3 && cur != 3 ) {
+            score[si] = 50;
+        }
+        else if ( ( prev == 0 && cur == 1 ) || ( prev != 2 && cur == 2 ) ) {
+            score[si] = 44;
+        }
+        else {
+            score[si] = cur == 3 ? 40 : 0;
+        }
+        prev   = cur;
+        dp[si] = min_score;
+    }
+    for ( pi = 0; pi < plen; pi++, pit = g_utf8_next_char ( pit ) ) {
+        gunichar pc = g_utf8_get_char ( pit ), sc;
+        if ( g_unichar_isspace ( pc ) ) {
+            pstart = TRUE;
+            continue;
+        }
+        lefts = min_score;
+        for ( si = 0, sit = str; si < slen; si++, sit = g_utf8_next_char ( sit ) ) {
+            left  = dp[si];
+            lefts = MAX ( lefts - 5, left );
+            sc    = g_utf8_get_char ( sit );
+            if ( config.case_sensitive
+                 ? pc == sc
+                 : g_unichar_tolower ( pc ) == g_unichar_tolower ( sc ) ) {
+                int t = score[si] * ( pstart ? 2 : 1 );
+                dp[si] = pfirst
+                         ? -4 * si + t
+                         : MAX ( uleft + 45, ulefts + t );
+            }
+            else {
+                dp[si] = min_score;
+            }
+            uleft  = left;
+            ulefts = lefts;
+        }
+        pfirst = pstart = FALSE;
+    }
+    lefts = min_score;
+    for ( si = 0; si < slen; si++ ) {
+        lefts = MAX ( lefts - 5, dp[si] );
+    }
+    g_free ( score );
+    g_free ( dp );
+    return -lefts;
+}
+
 int main ( int argc, char ** argv )
 {
     cmd_set_arguments ( argc, argv );
@@ -109,6 +179,57 @@ int main ( int argc, char ** argv )
     TASSERTE ( levenshtein ( "aap", g_utf8_strlen ( "aap", -1), "noot aap mies", g_utf8_strlen ( "noot aap mies", -1) ), 10 );
     TASSERTE ( levenshtein ( "noot aap mies", g_utf8_strlen ( "noot aap mies", -1), "aap", g_utf8_strlen ( "aap", -1) ), 10 );
     TASSERTE ( levenshtein ( "otp", g_utf8_strlen ( "otp", -1), "noot aap", g_utf8_strlen ( "noot aap", -1) ), 5 );
+    {
+        rofi_int_corpus_entry n, h;
+        helper_corpus_entry_init ( &n, "ÖTp", FALSE );
+        helper_corpus_entry_init ( &h, "noöt aap", FALSE );
+        TASSERT ( h.folded == NULL );
+        TASSERTE ( levenshtein_corpus ( &n, &h ), 5 );
+        helper_corpus_entry_clear ( &n );
+        helper_corpus_entry_init ( &n, "ÖTp", TRUE );
+        TASSERTE ( levenshtein_corpus ( &n, &h ), 7 );
+        TASSERTE ( levenshtein_corpus_bounded ( &n, &h, 7 ), 7 );
+        TASSERTE ( levenshtein_corpus_bounded ( &n, &h, 3 ), 4 );
+        TASSERTE ( levenshtein_corpus_bounded ( &n, &h, 0 ), 1 );
+        helper_corpus_entry_clear ( &n );
+        helper_corpus_entry_clear ( &h );
+    }
+    {
+        // Needles longer than one 64 character block.
+        const char *a = "the quick brown fox jumps over the lazy dog, the quick brown fox jumps over the lazy cat";
+        const char *b = "the quick brown fox jumps over the lazy dog, the quick brown fox jumps over a lazy cat";
+        TASSERTE ( levenshtein ( a, g_utf8_strlen ( a, -1 ), b, g_utf8_strlen ( b, -1 ) ), 3 );
+        TASSERTE ( levenshtein ( a, g_utf8_strlen ( a, -1 ), "", 0 ), 88 );
+        TASSERTE ( levenshtein ( "", 0, b, g_utf8_strlen ( b, -1 ) ), 86 );
+    }
+    {
+        // The fuzzy scorer should give the same scores as the reference, for ASCII and non-ASCII input.
+        const char   *alphabet[] = { "a", "b", "A", "B", "z", "1", "9", " ", "-", "_", "é", "É", "ß", "ö", "Ö", "日", "\t" };
+        const int    nalphabet   = sizeof ( alphabet ) / sizeof ( alphabet[0] );
+        GRand        *rand       = g_rand_new_with_seed ( 42 );
+        unsigned int mismatches  = 0;
+        for ( int i = 0; i < 20000; i++ ) {
+            GString *pattern = g_string_new ( "" );
+            GString *str     = g_string_new ( "" );
+            int     plen     = g_rand_int_range ( rand, 1, 6 );
+            int     slen     = g_rand_int_range ( rand, 0, i < 19990 ? 40 : 300 );
+            for ( int j = 0; j < plen; j++ ) {
+                g_string_append ( pattern, alphabet[g_rand_int_range ( rand, 0, nalphabet )] );
+            }
+            for ( int j = 0; j < slen; j++ ) {
+                g_string_append ( str, alphabet[g_rand_int_range ( rand, 0, nalphabet )] );
+            }
+            config.case_sensitive = i & 1;
+            if ( rofi_scorer_fuzzy_evaluate ( pattern->str, plen, str->str, slen ) != reference_fuzzy_evaluate ( pattern->str, plen, str->str, slen ) ) {
+                mismatches++;
+            }
+            g_string_free ( pattern, TRUE );
+            g_string_free ( str, TRUE );
+        }
+        config.case_sensitive = FALSE;
+        g_rand_free ( rand );
+        TASSERTE ( mismatches, 0 );
+    }
     /**
      * Quick converision check.
      */
@@ -129,6 +250,30 @@ int main ( int argc, char ** argv )
         TASSERT ( g_utf8_collate ( str, "Valid utf8 until �( we continue here" ) == 0 );
         g_free ( str );
     }
+    {
+        // Long ASCII runs, with the invalid byte on and around the block boundaries.
+        char in[] = "0123456789abcdef0123456789abcdef0123456789";
+        TASSERT ( rofi_utf8_validate ( in, strlen ( in ) ) == TRUE );
+        for ( size_t i = 0; i < strlen ( in ); i++ ) {
+            char c = in[i];
+            in[i] = '\xc3';
+            TASSERT ( rofi_utf8_validate ( in, strlen ( in ) ) == FALSE );
+            in[i] = '\0';
+            TASSERT ( rofi_utf8_validate ( in, sizeof ( in ) - 1 ) == FALSE );
+            in[i] = c;
+        }
+        TASSERT ( rofi_utf8_validate ( "0123456789abcdef\xc3\xb6", 18 ) == TRUE );
+        TASSERT ( rofi_utf8_validate ( "0123456789abcdef\xc3\xb6", 17 ) == FALSE );
+
+        char *str  = g_strdup ( "Valid utf8 ö" );
+        char *retv = rofi_force_utf8_take ( str, strlen ( str ) );
+        TASSERT ( retv == str );
+        g_free ( retv );
+        str  = g_strdup ( "Valid utf8 until \xc3\x28 we continue here" );
+        retv = rofi_force_utf8_take ( str, strlen ( str ) );
+        TASSERT ( g_utf8_collate ( retv, "Valid utf8 until �( we continue here" ) == 0 );
+        g_free ( retv );
+    }
     // Pid test.
     // Tests basic functionality of writing it, locking, seeing if I can write same again
     // And close/reopen it again.
@@ -30,6 +30,7 @@
 #include <glib.h>
 #include <stdio.h>
 #include <helper.h>
+#include <helper-theme.h>
 #include <string.h>
 #include <xcb/xcb_ewmh.h>
 #include "xcb-internal.h"
@@ -75,7 +76,7 @@ int main ( int argc, char ** argv )
     }
     {
         config.matching_method = MM_NORMAL;
-        GRegex **tokens = tokenize ( "noot", FALSE );
+        rofi_int_matcher **tokens = tokenize ( "noot", FALSE );
 
         TASSERT ( helper_token_match ( tokens, "aap noot mies") == TRUE );
         TASSERT ( helper_token_match ( tokens, "aap mies") == FALSE );
@@ -105,10 +106,22 @@ int main ( int argc, char ** argv )
         TASSERT ( helper_token_match ( tokens, "nootap mies") == TRUE );
         TASSERT ( helper_token_match ( tokens, "noap miesot") == TRUE );
         tokenize_free ( tokens );
+
+        tokens = tokenize ( "ÖNo", FALSE );
+        TASSERT ( helper_token_match ( tokens, "aap önoot mies") == TRUE );
+        TASSERT ( helper_token_match ( tokens, "aap ÖNOot mies") == TRUE );
+        TASSERT ( helper_token_match ( tokens, "aap noot mies") == FALSE );
+        TASSERT ( helper_token_match ( tokens, "aap ön") == FALSE );
+        tokenize_free ( tokens );
+
+        tokens = tokenize ( "a.p", FALSE );
+        TASSERT ( helper_token_match ( tokens, "A.P noot mies") == TRUE );
+        TASSERT ( helper_token_match ( tokens, "aap noot mies") == FALSE );
+        tokenize_free ( tokens );
     }
     {
         config.matching_method = MM_GLOB;
-        GRegex **tokens = tokenize ( "noot", FALSE );
+        rofi_int_matcher **tokens = tokenize ( "noot", FALSE );
 
         TASSERT ( helper_token_match ( tokens, "aap noot mies") == TRUE );
         TASSERT ( helper_token_match ( tokens, "aap mies") == FALSE );
@@ -162,10 +175,17 @@ int main ( int argc, char ** argv )
         TASSERT ( helper_token_match ( tokens, "noap miesot") == TRUE);
         TASSERT ( helper_token_match ( tokens, "ot nap mies") == TRUE);
         tokenize_free ( tokens );
+
+        tokens = tokenize ( "ö?t*s", FALSE );
+        TASSERT ( helper_token_match ( tokens, "aap Öot mies") == TRUE );
+        TASSERT ( helper_token_match ( tokens, "aap ö t mies") == FALSE );
+        TASSERT ( helper_token_match ( tokens, "aap öét\nmies") == FALSE );
+        TASSERT ( helper_token_match ( tokens, "aap öétmies") == TRUE );
+        tokenize_free ( tokens );
     }
     {
         config.matching_method = MM_FUZZY;
-        GRegex **tokens = tokenize ( "noot", FALSE );
+        rofi_int_matcher **tokens = tokenize ( "noot", FALSE );
 
         TASSERT ( helper_token_match ( tokens, "aap noot mies") == TRUE );
         TASSERT ( helper_token_match ( tokens, "aap mies") == FALSE );
@@ -218,10 +238,16 @@ int main ( int argc, char ** argv )
         TASSERT ( helper_token_match ( tokens, "noap miesot") == TRUE);
         TASSERT ( helper_token_match ( tokens, "ot nap mies") == TRUE);
         tokenize_free ( tokens );
+
+        tokens = tokenize ( "öt", FALSE );
+        TASSERT ( helper_token_match ( tokens, "aap nÖot mies") == TRUE );
+        TASSERT ( helper_token_match ( tokens, "aap nöo\nt mies") == FALSE );
+        TASSERT ( helper_token_match ( tokens, "aap noot mies") == FALSE );
+        tokenize_free ( tokens );
     }
     {
         config.matching_method = MM_REGEX;
-        GRegex **tokens = tokenize ( "noot", FALSE );
+        rofi_int_matcher **tokens = tokenize ( "noot", FALSE );
 
         TASSERT ( helper_token_match ( tokens, "aap noot mies") == TRUE );
         TASSERT ( helper_token_match ( tokens, "aap mies") == FALSE );
@@ -275,6 +301,101 @@ int main ( int argc, char ** argv )
         TASSERT ( helper_token_match ( tokens, "nootap mies") == FALSE );
         TASSERT ( helper_token_match ( tokens, "noap miesot") == TRUE);
         TASSERT ( helper_token_match ( tokens, "ot nap mies") == FALSE );
+        TASSERT ( helper_tokens_signature ( tokens ) == 0 );
         tokenize_free ( tokens );
     }
+    {
+        config.matching_method = MM_NORMAL;
+        rofi_int_matcher **tokens   = tokenize ( "nÖ t", FALSE );
+        guint64          signature = helper_tokens_signature ( tokens );
+        TASSERT ( ( helper_token_match_signature ( "aap NöoT" ) & signature ) == signature );
+        TASSERT ( ( helper_token_match_signature ( "aap Nooo" ) & signature ) != signature );
+        TASSERT ( ( helper_token_match_signature ( NULL ) & signature ) != signature );
+        tokenize_free ( tokens );
+    }
+    {
+        config.matching_method = MM_NORMAL;
+        char             *lines[] = { "aap noot", "Noot mies", "mies", "nöot", NULL };
+        RofiTrigramIndex *index   = helper_trigram_index_new ( lines, 4, NULL );
+        unsigned int     length   = 0;
+        rofi_int_matcher **tokens = tokenize ( "noo", FALSE );
+        unsigned int     *cand    = helper_trigram_index_query ( index, tokens, &length );
+        TASSERT ( length == 2 );
+        TASSERT ( cand[0] == 0 && cand[1] == 1 );
+        g_free ( cand );
+        tokenize_free ( tokens );
+
+        // The index is case folded, so it gives a super-set.
+        tokens = tokenize ( "noo mie", TRUE );
+        cand   = helper_trigram_index_query ( index, tokens, &length );
+        TASSERT ( length == 1 );
+        TASSERT ( cand[0] == 1 );
+        TASSERT ( helper_token_match ( tokens, lines[cand[0]] ) == FALSE );
+        g_free ( cand );
+        tokenize_free ( tokens );
+
+        tokens = tokenize ( "no", FALSE );
+        TASSERT ( helper_trigram_index_query ( index, tokens, &length ) == NULL );
+        tokenize_free ( tokens );
+        helper_trigram_index_free ( index );
+    }
+    {
+        config.matching_method = MM_NORMAL;
+        // Literal tokens are found in one pass, overlapping and repeated needles.
+        rofi_int_matcher **tokens = tokenize ( "Aap ap pno öt ap", FALSE );
+        TASSERT ( helper_token_match ( tokens, "aapnoot" ) == FALSE );
+        TASSERT ( helper_token_match ( tokens, "AAPNOÖT" ) == TRUE );
+        TASSERT ( helper_token_match ( tokens, "aa pno öt" ) == FALSE );
+        TASSERT ( helper_token_match ( tokens, "apno öt aap" ) == TRUE );
+        rofi_int_matcher *ftokens[2] = { tokens[0], NULL };
+        TASSERT ( helper_token_match ( ftokens, "aap" ) == TRUE );
+        tokenize_free ( tokens );
+
+        tokens = tokenize ( "Aap noot", TRUE );
+        TASSERT ( helper_token_match ( tokens, "Aap noot" ) == TRUE );
+        TASSERT ( helper_token_match ( tokens, "aap noot" ) == FALSE );
+        tokenize_free ( tokens );
+
+        const char *fields[] = { "aap", NULL, "noot mies" };
+        tokens = tokenize ( "mie aap", FALSE );
+        TASSERT ( helper_token_match_fields ( tokens, fields, 3 ) == TRUE );
+        TASSERT ( helper_token_match_fields ( tokens, fields, 2 ) == FALSE );
+        tokenize_free ( tokens );
+        tokens = tokenize ( "mie ap noot", FALSE );
+        TASSERT ( helper_token_match_fields ( tokens, fields, 3 ) == TRUE );
+        TASSERT ( helper_token_match_fields ( tokens, fields + 2, 1 ) == FALSE );
+        tokenize_free ( tokens );
+
+        config.matching_method = MM_REGEX;
+        tokens                 = tokenize ( "aap n[oa]+t", FALSE );
+        TASSERT ( helper_token_match_fields ( tokens, fields, 3 ) == TRUE );
+        TASSERT ( helper_token_match ( tokens, "noot aap" ) == TRUE );
+        TASSERT ( helper_token_match ( tokens, "nt aap" ) == FALSE );
+        tokenize_free ( tokens );
+        config.matching_method = MM_NORMAL;
+    }
+    {
+        // Every fuzzy match is highlighted, not only the first.
+        config.matching_method = MM_FUZZY;
+        rofi_int_matcher **tokens = tokenize ( "a", FALSE );
+        GArray           *ranges  = helper_token_match_get_ranges ( tokens, "aXa\na" );
+        TASSERT ( ranges->len == 3 );
+        TASSERT ( g_array_index ( ranges, rofi_range_pair, 0 ).start == 0 );
+        TASSERT ( g_array_index ( ranges, rofi_range_pair, 1 ).start == 2 );
+        TASSERT ( g_array_index ( ranges, rofi_range_pair, 2 ).start == 4 );
+        g_array_free ( ranges, TRUE );
+        tokenize_free ( tokens );
+
+        // One match per line, the last character as late as possible on the line.
+        tokens = tokenize ( "ab", FALSE );
+        ranges = helper_token_match_get_ranges ( tokens, "ab ab\nxab" );
+        TASSERT ( ranges->len == 4 );
+        TASSERT ( g_array_index ( ranges, rofi_range_pair, 0 ).start == 0 );
+        TASSERT ( g_array_index ( ranges, rofi_range_pair, 1 ).start == 4 );
+        TASSERT ( g_array_index ( ranges, rofi_range_pair, 2 ).start == 7 );
+        TASSERT ( g_array_index ( ranges, rofi_range_pair, 3 ).start == 8 );
+        g_array_free ( ranges, TRUE );
+        tokenize_free ( tokens );
+        config.matching_method = MM_NORMAL;
+    }
 }
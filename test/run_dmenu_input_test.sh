@@ -0,0 +1,76 @@
+#!/usr/bin/env bash
+
+# Read the input the way given as the first argument:
+#  file:   -input <file> (memory mapped)
+#  async:  stdin, async reader
+#  thread: stdin, -async-read-thread
+MODE=${1:-file}
+INPUT=input.txt
+
+# Run rofi on ${INPUT}, type $2 and return the selected entry in output.txt.
+# $1 the extra rofi options.
+# Nothing is pre-read, so all lines go through the background reader.
+function run_rofi ( )
+{
+    set -- "-async-pre-read 0 $1" "$2"
+    case "${MODE}" in
+        file)
+            rofi -dmenu -input "${INPUT}" $1 < /dev/null > output.txt &
+            ;;
+        async)
+            cat "${INPUT}" | rofi -dmenu $1 > output.txt &
+            ;;
+        thread)
+            cat "${INPUT}" | rofi -dmenu -async-read-thread $1 > output.txt &
+            ;;
+    esac
+    RPID=$!
+    sleep 3;
+    xdotool type --delay 200 "$2"
+    sleep 0.4
+    xdotool key Return
+    wait ${RPID}
+    RETV=$?
+    if [ ${RETV} -ne 0 ]
+    then
+        echo "${MODE}: rofi exited with ${RETV}"
+        exit 1
+    fi
+}
+
+# $1 the test, $2 the expected output.
+function check_output ( )
+{
+    if ! printf "%s\n" "$2" | cmp -s - output.txt
+    then
+        echo "${MODE} $1: got '$(head -c 80 output.txt)' expected '$(printf "%s" "$2" | head -c 80)'"
+        exit 1
+    fi
+}
+
+# Unterminated last line.
+printf "aap\nnoot\nmies" > "${INPUT}"
+run_rofi "" "mies"
+check_output "unterminated" "mies"
+
+# Invalid UTF-8 is replaced.
+printf "aap\nbad\xffline\nmies\n" > "${INPUT}"
+run_rofi "" "line"
+check_output "invalid utf-8" "$(printf "bad\xef\xbf\xbdline")"
+
+# Custom separator, the newline is part of an entry.
+printf "aap|no\not|mies|" > "${INPUT}"
+run_rofi "-sep |" "mies"
+check_output "separator" "mies"
+run_rofi "-sep | -format i" "ot"
+check_output "separator" "1"
+
+# Records larger than the 256 KiB read buffer.
+LONG=$(head -c 300000 /dev/zero | tr '\0' 'x')
+printf "aap\nlong%s\nnoot\n%s\ntail" "${LONG}" "${LONG}" > "${INPUT}"
+run_rofi "" "long"
+check_output "large record" "long${LONG}"
+run_rofi "-format i" "tail"
+check_output "large record" "4"
+
+exit 0